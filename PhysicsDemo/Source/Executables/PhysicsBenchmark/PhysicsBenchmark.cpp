@@ -0,0 +1,1010 @@
+#include "Platform/Timer.h"
+
+#include "Systems/Entity.h"
+#include "Systems/Broadphase.h"
+#include "Systems/UniformGrid.h"
+#include "Systems/SweepAndPrune.h"
+#include "Systems/TreeBroadphase.h"
+#include "Systems/Collision.h"
+#include "Systems/Components.h"
+#include "Systems/Simulation.h"
+#include "Systems/Shapes.h"
+
+#include "Contact.h"
+#include "SphereBatch.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <thread>
+
+namespace jm
+{
+	//spheres are spread at a fixed density so the number of true contacts grows linearly with the count
+	constexpr f32 VolumePerSphere = 27.0f;
+
+	struct BenchmarkTimer
+	{
+		BenchmarkTimer()
+		{
+			Timer.Initialize();
+		}
+
+		template <typename Fxn>
+		f64 Measure(Fxn&& function)
+		{
+			const f64 start = Timer.GetTime();
+			function();
+			return Timer.GetTime() - start;
+		}
+
+		Platform::Timer Timer;
+	};
+
+	std::vector<collision_proxy> MakeSphereScene(entity_registry& registry, uSize count)
+	{
+		const f32 halfSide = 0.5f * std::cbrt(VolumePerSphere * static_cast<f32>(count));
+
+		std::vector<collision_proxy> proxies;
+		proxies.reserve(count);
+		for (uSize i = 0; i < count; ++i)
+		{
+			const math::vector3_f32 center = {
+				math::random::scalar(-halfSide, halfSide),
+				math::random::scalar(-halfSide, halfSide),
+				math::random::scalar(-halfSide, halfSide) };
+			proxies.push_back({ registry.create(), math::bounding_box(math::sphere3<f32>{ center, 1.0f }) });
+		}
+		return proxies;
+	}
+
+	//a square of columns of unit bodies, laid out by AddColumns
+	struct ColumnLayout
+	{
+		uSize side = 16; //columns along x and along z
+		uSize layers = 4; //bodies in a column
+		f32 spacing = 4.0f; //between columns
+		f32 base = 1.0f; //height of the lowest body
+		f32 rise = 2.0f; //from one body of a column to the next
+		f32 offset = 0.0f; //moves every other layer along x and z, to lay boxes like bricks
+		f32 jitter = 0.0f; //moves every body along x and z by up to this, the same way on every call
+		bool floors = true; //a static box under every column
+	};
+
+	void AddColumns(entity_registry& registry, ColumnLayout const& layout, shape_component shape)
+	{
+		math::random::uniform_generator<f32> jitter(17, -layout.jitter, layout.jitter);
+		for (uSize x = 0; x < layout.side; ++x)
+		{
+			for (uSize z = 0; z < layout.side; ++z)
+			{
+				const f32 columnX = layout.spacing * static_cast<f32>(x);
+				const f32 columnZ = layout.spacing * static_cast<f32>(z);
+				if (layout.floors)
+				{
+					entity_id floor = registry.create();
+					registry.emplace<spatial3_component>(floor, math::vector3_f32{ columnX, -1.0f, columnZ }, math::quaternion_f32{ 1.0f, 0.0f, 0.0f, 0.0f });
+					registry.emplace<shape_component>(floor, shape_component::Box);
+				}
+
+				for (uSize layer = 0; layer < layout.layers; ++layer)
+				{
+					math::vector3_f32 position{ columnX, layout.base + layout.rise * static_cast<f32>(layer), columnZ };
+					if (layer % 2 == 1)
+					{
+						position += math::vector3_f32{ layout.offset, 0.0f, layout.offset };
+					}
+					if (layout.jitter > 0.0f)
+					{
+						position.x += jitter();
+						position.z += jitter();
+					}
+
+					entity_id body = registry.create();
+					registry.emplace<spatial3_component>(body, position, math::quaternion_f32{ 1.0f, 0.0f, 0.0f, 0.0f });
+					registry.emplace<shape_component>(body, shape);
+					registry.emplace<linear_body3_component>(body, math::zero3, 2.0f);
+				}
+			}
+		}
+	}
+
+	//the jittered lattice the granular piles are dropped from, without floors as each builds its own
+	ColumnLayout PileLayout(uSize side, uSize layers)
+	{
+		ColumnLayout layout;
+		layout.side = side;
+		layout.layers = layers;
+		layout.spacing = 2.5f;
+		layout.base = 1.5f;
+		layout.rise = 2.2f;
+		layout.jitter = 0.2f;
+		layout.floors = false;
+		return layout;
+	}
+
+	void BenchmarkBroadphasePairs(BenchmarkTimer& timer)
+	{
+		constexpr uSize BruteForceLimit = 50'000;
+		worker_pool workers;
+
+		std::printf("Broadphase pair generation (unit spheres)\n");
+		std::printf("%10s %14s %14s %12s\n", "spheres", "brute [ms]", "grid [ms]", "pairs");
+
+		for (uSize count : { 10'000ull, 30'000ull, 100'000ull, 300'000ull, 1'000'000ull })
+		{
+			entity_registry registry;
+			std::vector<collision_proxy> proxies = MakeSphereScene(registry, count);
+			std::vector<collision_pair> pairs;
+			pairs.reserve(4 * count);
+
+			f64 bruteTime = -1.0;
+			if (count <= BruteForceLimit)
+			{
+				brute_force_broadphase bruteForce;
+				bruteTime = timer.Measure([&]() { bruteForce.find_pairs(proxies, pairs); });
+			}
+
+			uniform_grid_broadphase grid(workers, 2.0f);
+			const f64 gridTime = timer.Measure([&]() { grid.find_pairs(proxies, pairs); });
+
+			if (bruteTime < 0.0)
+			{
+				std::printf("%10zu %14s %14.3f %12zu\n", count, "skipped", 1000.0 * gridTime, pairs.size());
+			}
+			else
+			{
+				std::printf("%10zu %14.3f %14.3f %12zu\n", count, 1000.0 * bruteTime, 1000.0 * gridTime, pairs.size());
+			}
+		}
+		std::printf("\n");
+	}
+
+	//the grid split across threads, pairs must come out identical to the single threaded run
+	void BenchmarkParallelGrid(BenchmarkTimer& timer)
+	{
+		constexpr uSize Repeats = 3;
+		const u32 hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		worker_pool workers;
+
+		std::printf("Parallel grid pair generation (unit spheres), best of %zu, %u hardware threads\n", Repeats, hardwareThreads);
+		std::printf("%10s %8s %14s %10s %12s\n", "spheres", "threads", "grid [ms]", "speedup", "identical");
+
+		for (uSize count : { 100'000ull, 500'000ull })
+		{
+			entity_registry registry;
+			std::vector<collision_proxy> proxies = MakeSphereScene(registry, count);
+			std::vector<collision_pair> serialPairs;
+			std::vector<collision_pair> pairs;
+
+			f64 serialTime = 0.0;
+			for (u32 threads : { 1u, 2u, 4u, 8u, 16u })
+			{
+				uniform_grid_broadphase grid(workers, 2.0f, threads);
+				f64 gridTime = std::numeric_limits<f64>::max();
+				for (uSize repeat = 0; repeat < Repeats; ++repeat)
+				{
+					gridTime = std::min(gridTime, timer.Measure([&]() { grid.find_pairs(proxies, threads == 1 ? serialPairs : pairs); }));
+				}
+
+				if (threads == 1)
+				{
+					serialTime = gridTime;
+					std::printf("%10zu %8u %14.3f %10.2f %12s\n", count, threads, 1000.0 * gridTime, 1.0, "-");
+				}
+				else
+				{
+					std::printf("%10zu %8u %14.3f %10.2f %12s\n", count, threads, 1000.0 * gridTime, serialTime / gridTime, pairs == serialPairs ? "yes" : "no");
+				}
+			}
+		}
+		std::printf("\n");
+	}
+
+	//bodies drift a little each tick, the case sweep and prune is built for
+	void BenchmarkCoherentMotion(BenchmarkTimer& timer)
+	{
+		constexpr uSize Ticks = 20;
+		worker_pool workers;
+
+		std::printf("Coherent motion, average per tick over %zu ticks (unit spheres)\n", Ticks);
+		std::printf("%10s %10s %14s %14s %14s\n", "spheres", "drift", "grid [ms]", "sap [ms]", "sap changes");
+
+		for (uSize count : { 10'000ull, 100'000ull })
+		{
+			for (f32 driftPerTick : { 0.002f, 0.02f })
+			{
+				entity_registry registry;
+				std::vector<collision_proxy> proxies = MakeSphereScene(registry, count);
+				std::vector<collision_pair> pairs;
+				collision_pair_changes changes;
+
+				uniform_grid_broadphase grid(workers, 2.0f);
+				sweep_and_prune_broadphase sweepAndPrune;
+				sweepAndPrune.find_pair_changes(proxies, changes);
+
+				f64 gridTime = 0.0;
+				f64 sweepAndPruneTime = 0.0;
+				uSize changeCount = 0;
+				for (uSize tick = 0; tick < Ticks; ++tick)
+				{
+					for (collision_proxy& proxy : proxies)
+					{
+						const math::vector3_f32 drift = driftPerTick * math::random::unit_ball<f32>();
+						proxy.bounds = { proxy.bounds.min + drift, proxy.bounds.max + drift };
+					}
+
+					gridTime += timer.Measure([&]() { grid.find_pairs(proxies, pairs); });
+					sweepAndPruneTime += timer.Measure([&]() { sweepAndPrune.find_pair_changes(proxies, changes); });
+					changeCount += changes.added.size() + changes.removed.size();
+				}
+
+				std::printf("%10zu %10.3f %14.3f %14.3f %14zu\n", count, driftPerTick, 1000.0 * gridTime / Ticks, 1000.0 * sweepAndPruneTime / Ticks, changeCount / Ticks);
+			}
+		}
+		std::printf("\n");
+	}
+}
+
+namespace jm
+{
+	//radii spread over two orders of magnitude, the grid has to size its cells for the largest or fall back to brute force.
+	//Times are for the tick after the first, once the incremental broadphases have built their state.
+	void BenchmarkMixedSizes(BenchmarkTimer& timer)
+	{
+		constexpr f32 MinRadius = 0.1f;
+		constexpr f32 MaxRadius = 10.0f;
+		worker_pool workers;
+
+		std::printf("Mixed sizes, radius %.1f to %.1f, second tick\n", MinRadius, MaxRadius);
+		std::printf("%10s %14s %14s %14s %12s\n", "bodies", "grid [ms]", "sap [ms]", "tree [ms]", "pairs");
+
+		for (uSize count : { 10'000ull, 100'000ull })
+		{
+			entity_registry registry;
+			std::vector<collision_proxy> proxies = MakeSphereScene(registry, count);
+			for (collision_proxy& proxy : proxies)
+			{
+				const f32 radius = MinRadius * std::pow(MaxRadius / MinRadius, math::random::unit<f32>() * math::random::unit<f32>());
+				proxy.bounds = math::inflate({ math::center(proxy.bounds), math::center(proxy.bounds) }, radius);
+			}
+			std::vector<collision_pair> pairs;
+
+			auto measureSecondTick = [&](broadphase& pairFinder)
+			{
+				pairFinder.find_pairs(proxies, pairs);
+				return timer.Measure([&]() { pairFinder.find_pairs(proxies, pairs); });
+			};
+
+			uniform_grid_broadphase grid(workers, 2.0f);
+			const f64 gridTime = measureSecondTick(grid);
+
+			sweep_and_prune_broadphase sweepAndPrune;
+			const f64 sweepAndPruneTime = measureSecondTick(sweepAndPrune);
+
+			dynamic_tree_broadphase tree(0.1f);
+			const f64 treeTime = measureSecondTick(tree);
+
+			std::printf("%10zu %14.3f %14.3f %14.3f %12zu\n", count, 1000.0 * gridTime, 1000.0 * sweepAndPruneTime, 1000.0 * treeTime, pairs.size());
+		}
+		std::printf("\n");
+	}
+
+	//random boxes with centres up to three units apart so about one pair in five touches
+	void BenchmarkBoxBox(BenchmarkTimer& timer)
+	{
+		constexpr uSize Repeats = 5;
+
+		std::printf("Box-box separating axis narrowphase, best of %zu\n", Repeats);
+		std::printf("%10s %10s %18s %18s\n", "pairs", "touching", "scalar [pairs/s]", "batched [pairs/s]");
+
+		for (uSize count : { 10'000ull, 100'000ull, 1'000'000ull })
+		{
+			std::vector<math::box3<f32>> a(count);
+			std::vector<math::box3<f32>> b(count);
+			for (uSize i = 0; i < count; ++i)
+			{
+				for (math::box3<f32>* box : { &a[i], &b[i] })
+				{
+					box->extents = { math::random::scalar(0.25f, 1.0f), math::random::scalar(0.25f, 1.0f), math::random::scalar(0.25f, 1.0f) };
+					box->axes = glm::mat3_cast(math::random::unit_quaternion<f32>());
+				}
+				b[i].position = 3.0f * math::random::unit_ball<f32>();
+			}
+
+			std::vector<math::contact_manifold3<f32>> manifolds(count);
+			uSize touching = 0;
+			f64 scalarTime = std::numeric_limits<f64>::max();
+			f64 batchedTime = std::numeric_limits<f64>::max();
+			for (uSize repeat = 0; repeat < Repeats; ++repeat)
+			{
+				scalarTime = std::min(scalarTime, timer.Measure([&]()
+					{
+						touching = 0;
+						for (uSize i = 0; i < count; ++i)
+						{
+							touching += math::collide(a[i], b[i], manifolds[i]) ? 1 : 0;
+						}
+					}));
+				batchedTime = std::min(batchedTime, timer.Measure([&]() { touching = math::collide(a, b, manifolds); }));
+			}
+
+			std::printf("%10zu %10zu %18.3e %18.3e\n", count, touching, static_cast<f64>(count) / scalarTime, static_cast<f64>(count) / batchedTime);
+		}
+		std::printf("\n");
+	}
+
+	//sphere pairs with centres up to four units apart so about one in twenty touch, the AoS loop is the per pair test the batch replaces
+	void BenchmarkSphereBatch(BenchmarkTimer& timer)
+	{
+		constexpr uSize Repeats = 5;
+		const bool hasAvx2 = math::get_best_simd_level() == math::simd_level::AVX2;
+
+		std::printf("Sphere-sphere narrowphase, best of %zu\n", Repeats);
+		std::printf("%10s %10s %18s %18s %18s %18s\n", "pairs", "touching", "AoS [pairs/s]", "scalar [pairs/s]", "SSE [pairs/s]", "AVX2 [pairs/s]");
+
+		for (uSize count : { 10'000ull, 100'000ull, 1'000'000ull })
+		{
+			std::vector<math::sphere3<f32>> a(count);
+			std::vector<math::sphere3<f32>> b(count);
+			math::sphere_pair_batch batch;
+			batch.reserve(count);
+			for (uSize i = 0; i < count; ++i)
+			{
+				a[i] = { math::random::unit_ball<f32>(), math::random::scalar(0.5f, 1.0f) };
+				b[i] = { a[i].center + 4.0f * math::random::unit_ball<f32>(), math::random::scalar(0.5f, 1.0f) };
+				batch.push_back(a[i], b[i]);
+			}
+
+			std::vector<math::contact_manifold3<f32>> manifolds(count);
+			math::sphere_contact_batch contacts;
+			uSize touching = 0;
+			f64 aosTime = std::numeric_limits<f64>::max();
+			f64 levelTimes[3] = { aosTime, aosTime, aosTime };
+			for (uSize repeat = 0; repeat < Repeats; ++repeat)
+			{
+				aosTime = std::min(aosTime, timer.Measure([&]()
+					{
+						touching = 0;
+						for (uSize i = 0; i < count; ++i)
+						{
+							const math::vector3_f32 displacement = b[i].center - a[i].center;
+							const f32 distance = glm::length(displacement);
+							manifolds[i].normal = distance > 0.0f ? displacement / distance : math::vector3_f32{ 0.0f, 1.0f, 0.0f };
+							manifolds[i].points[0].depth = a[i].radius + b[i].radius - distance;
+							touching += manifolds[i].points[0].depth >= 0.0f ? 1 : 0;
+						}
+					}));
+
+				for (math::simd_level level : { math::simd_level::Scalar, math::simd_level::SSE, math::simd_level::AVX2 })
+				{
+					if (level != math::simd_level::AVX2 || hasAvx2)
+					{
+						f64& levelTime = levelTimes[static_cast<uSize>(level)];
+						levelTime = std::min(levelTime, timer.Measure([&]() { touching = math::collide(batch, contacts, level); }));
+					}
+				}
+			}
+
+			std::printf("%10zu %10zu %18.3e %18.3e %18.3e", count, touching, static_cast<f64>(count) / aosTime,
+				static_cast<f64>(count) / levelTimes[0], static_cast<f64>(count) / levelTimes[1]);
+			if (hasAvx2)
+			{
+				std::printf(" %18.3e\n", static_cast<f64>(count) / levelTimes[2]);
+			}
+			else
+			{
+				std::printf(" %18s\n", "n/a");
+			}
+		}
+		std::printf("\n");
+	}
+
+	//columns of unit spheres resting on static boxes, the pipeline runs until the columns settle and then the solve alone is timed
+	void BenchmarkStacking(BenchmarkTimer& timer)
+	{
+		constexpr f32 TickPeriod = 1.0f / 60.0f;
+		constexpr uSize SettleTicks = 300;
+		constexpr uSize Repeats = 20;
+		constexpr uSize Columns = 256;
+
+		std::printf("Stacking, %zu columns settled for %zu ticks, solve averaged over %zu runs\n", Columns, SettleTicks, Repeats);
+		std::printf("%8s %10s %8s %8s %12s %16s %14s\n", "height", "rows", "solver", "steps", "solve [ms]", "per row [ns]", "max depth");
+
+		struct configuration
+		{
+			bool temporal;
+			u32 steps; //iterations of Gauss-Seidel or substeps of temporal Gauss-Seidel, about the same cost per row either way
+		};
+
+		for (uSize height : { 4ull, 16ull })
+		{
+			for (configuration const& config : { configuration{ false, 4 }, configuration{ false, 8 }, configuration{ false, 16 },
+				configuration{ true, 4 }, configuration{ true, 8 }, configuration{ true, 16 } })
+			{
+				entity_registry registry;
+				ColumnLayout layout;
+				layout.side = static_cast<uSize>(std::sqrt(static_cast<f64>(Columns)));
+				layout.layers = height;
+				AddColumns(registry, layout, shape_component::Sphere);
+
+				collision_settings settings;
+				settings.solver.iterations = config.steps;
+				settings.solver.substeps = config.temporal ? config.steps : 0;
+				settings.sleep_time = 0.0f; //keep the columns in the solve
+				collision_world world(settings);
+				world.bake_static_bodies(registry);
+				for (uSize tick = 0; tick < SettleTicks; ++tick)
+				{
+					integrate(registry, TickPeriod);
+					resolve_collisions(registry, world, TickPeriod);
+				}
+
+				f32 maxDepth = 0.0f;
+				for (math::contact_manifold3<f32> const& manifold : world.manifolds)
+				{
+					for (u32 point = 0; point < manifold.point_count; ++point)
+					{
+						maxDepth = std::max(maxDepth, manifold.points[point].depth);
+					}
+				}
+
+				const f64 solveTime = timer.Measure([&]()
+					{
+						for (uSize repeat = 0; repeat < Repeats; ++repeat)
+						{
+							world.solver.solve(registry, world.contacts, world.manifolds, world.settings.solver, TickPeriod);
+						}
+					}) / Repeats;
+
+				const uSize rows = world.solver.get_row_count();
+				std::printf("%8zu %10zu %8s %8u %12.3f %16.1f %14.4f\n", height, rows, config.temporal ? "tgs" : "pgs", config.steps, 1000.0 * solveTime, 1e9 * solveTime / static_cast<f64>(std::max<uSize>(rows, 1)), maxDepth);
+			}
+		}
+		std::printf("\n");
+	}
+
+	//One island of unit boxes laid like bricks, every layer offset by half a box so each box rests on four below. The serial
+	//solve runs the whole island on one thread, the coloured one splits each colour across the workers.
+	void BenchmarkColoring(BenchmarkTimer& timer)
+	{
+		constexpr f32 TickPeriod = 1.0f / 60.0f;
+		constexpr uSize SettleTicks = 20;
+		constexpr uSize Repeats = 10;
+		constexpr uSize Side = 22;
+		constexpr uSize Layers = 21;
+
+		std::printf("Graph colouring, %zu boxes in one island, solve averaged over %zu runs\n", Side * Side * Layers, Repeats);
+		std::printf("%10s %8s %10s %8s %12s\n", "solver", "threads", "rows", "colours", "solve [ms]");
+
+		const u32 hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::pair<bool, u32>> configurations = { { false, 1u }, { true, 1u } };
+		for (u32 threads = 2; threads <= hardwareThreads; threads *= 2)
+		{
+			configurations.push_back({ true, threads });
+		}
+
+		for (auto [coloring, threads] : configurations)
+		{
+			entity_registry registry;
+			ColumnLayout layout;
+			layout.side = Side;
+			layout.layers = Layers;
+			layout.spacing = 2.0f;
+			layout.base = 0.99f;
+			layout.rise = 1.99f;
+			layout.offset = 1.0f;
+			AddColumns(registry, layout, shape_component::Box);
+
+			collision_settings settings;
+			settings.sleep_time = 0.0f;
+			settings.solver.graph_coloring = coloring;
+			settings.solver.thread_count = threads;
+			collision_world world(settings);
+			world.bake_static_bodies(registry);
+			for (uSize tick = 0; tick < SettleTicks; ++tick)
+			{
+				integrate(registry, TickPeriod);
+				resolve_collisions(registry, world, TickPeriod);
+			}
+
+			const f64 solveTime = timer.Measure([&]()
+				{
+					for (uSize repeat = 0; repeat < Repeats; ++repeat)
+					{
+						world.solver.solve(registry, world.contacts, world.manifolds, world.settings.solver, TickPeriod);
+					}
+				}) / Repeats;
+
+			std::printf("%10s %8u %10zu %8zu %12.3f\n", coloring ? "coloured" : "serial", threads, world.solver.get_row_count(), world.solver.get_color_count(), 1000.0 * solveTime);
+		}
+		std::printf("\n");
+	}
+
+	//A granular pile of unit spheres dropped from a jittered lattice into a box built from statics, run through the whole
+	//pipeline. Depth is the deepest overlap left once the pile has settled, between spheres or into the floor.
+	void BenchmarkXpbd(BenchmarkTimer& timer)
+	{
+		constexpr f32 TickPeriod = 1.0f / 60.0f;
+		constexpr uSize Ticks = 240;
+		constexpr uSize Side = 16;
+		constexpr uSize Layers = 16;
+		constexpr uSize FloorSide = Side + Side / 4 + 2; //tiles of two metres under the columns, which are two and a half apart
+		constexpr uSize WallLayers = 12; //the pile is boxed in so every configuration settles into the same footprint
+
+		std::printf("XPBD against impulses, %zu spheres dropped into a box, %zu ticks\n", Side * Side * Layers, Ticks);
+		std::printf("%10s %10s %12s %12s\n", "solver", "steps", "tick [ms]", "max depth");
+
+		struct configuration
+		{
+			solver_type mode;
+			u32 steps; //iterations for impulses, substeps for XPBD
+		};
+
+		for (configuration const& config : { configuration{ solver_type::Impulse, 8 }, configuration{ solver_type::Impulse, 16 },
+			configuration{ solver_type::Xpbd, 4 }, configuration{ solver_type::Xpbd, 8 }, configuration{ solver_type::Xpbd, 16 } })
+		{
+			entity_registry registry;
+			const auto add_static_box = [&](f32 x, f32 y, f32 z)
+				{
+					entity_id box = registry.create();
+					registry.emplace<spatial3_component>(box, math::vector3_f32{ x, y, z }, math::quaternion_f32{ 1.0f, 0.0f, 0.0f, 0.0f });
+					registry.emplace<shape_component>(box, shape_component::Box);
+				};
+
+			for (uSize x = 0; x < FloorSide; ++x)
+			{
+				for (uSize z = 0; z < FloorSide; ++z)
+				{
+					add_static_box(2.0f * static_cast<f32>(x) - 2.0f, -1.0f, 2.0f * static_cast<f32>(z) - 2.0f);
+				}
+			}
+			for (uSize layer = 0; layer < WallLayers; ++layer)
+			{
+				const f32 y = 1.0f + 2.0f * static_cast<f32>(layer);
+				const f32 near_side = -4.0f;
+				const f32 far_side = 2.0f * static_cast<f32>(FloorSide) - 2.0f;
+				for (uSize tile = 0; tile < FloorSide; ++tile)
+				{
+					const f32 along = 2.0f * static_cast<f32>(tile) - 2.0f;
+					add_static_box(near_side, y, along);
+					add_static_box(far_side, y, along);
+					add_static_box(along, y, near_side);
+					add_static_box(along, y, far_side);
+				}
+			}
+
+			//columns are far enough apart that no two spheres start out overlapping, the same jitter gives every solver the same pile
+			AddColumns(registry, PileLayout(Side, Layers), shape_component::Sphere);
+
+			collision_settings settings;
+			settings.sleep_time = 0.0f;
+			settings.grid_cell_size = 3.0f; //XPBD proxies cover a step of motion plus the pair margin
+			settings.solver_mode = config.mode;
+			settings.solver.iterations = config.steps;
+			settings.xpbd.substeps = config.steps;
+			collision_world world(settings);
+			world.bake_static_bodies(registry);
+
+			const f64 tickTime = timer.Measure([&]()
+				{
+					for (uSize tick = 0; tick < Ticks; ++tick)
+					{
+						simulate(registry, world, TickPeriod);
+					}
+				}) / Ticks;
+
+			f32 maxDepth = 0.0f;
+			for (collision_pair const& pair : world.contacts)
+			{
+				spatial3_component const& a = registry.get<spatial3_component>(pair.a);
+				spatial3_component const& b = registry.get<spatial3_component>(pair.b);
+				if (registry.get<shape_component>(pair.a) == shape_component::Sphere && registry.get<shape_component>(pair.b) == shape_component::Sphere)
+				{
+					maxDepth = std::max(maxDepth, 2.0f - glm::length(a.position - b.position));
+					continue;
+				}
+
+				math::contact_manifold3<f32> manifold;
+				const bool a_sphere = registry.get<shape_component>(pair.a) == shape_component::Sphere;
+				if (a_sphere ? math::collide(make_sphere(a), make_box(b), manifold) : math::collide(make_box(a), make_sphere(b), manifold))
+				{
+					maxDepth = std::max(maxDepth, manifold.points[0].depth);
+				}
+			}
+
+			std::printf("%10s %10u %12.3f %12.4f\n", config.mode == solver_type::Xpbd ? "xpbd" : "impulse", config.steps, 1000.0 * tickTime, maxDepth);
+		}
+		std::printf("\n");
+	}
+
+	//Chains of spheres on distance joints held out level from points in the world and let swing, as many short chains or a few
+	//long ones with the same number of links. Long chains make islands large enough to colour. Stretch is the largest error
+	//left at a joint.
+	void BenchmarkJoints(BenchmarkTimer& timer)
+	{
+		constexpr f32 TickPeriod = 1.0f / 60.0f;
+		constexpr uSize Ticks = 120;
+		constexpr uSize Links = 8192;
+		constexpr f32 LinkSpacing = 2.5f;
+
+		std::printf("Joints, %zu links in chains swinging for %zu ticks\n", Links, Ticks);
+		std::printf("%8s %8s %8s %8s %10s %10s %12s %12s\n", "chains", "solver", "steps", "islands", "rows", "colours", "tick [ms]", "stretch");
+
+		struct configuration
+		{
+			uSize chains;
+			bool temporal;
+			u32 steps;
+		};
+
+		for (configuration const& config : { configuration{ 256, false, 8 }, configuration{ 256, true, 8 }, configuration{ 8, false, 8 }, configuration{ 8, true, 8 } })
+		{
+			entity_registry registry;
+			const math::vector3_f32 halfLink = { 0.5f * LinkSpacing, 0.0f, 0.0f };
+			for (uSize chain = 0; chain < config.chains; ++chain)
+			{
+				const math::vector3_f32 top = { 0.0f, 0.0f, 4.0f * static_cast<f32>(chain) };
+				entity_id previous = null_entity_id;
+				for (uSize link = 0; link < Links / config.chains; ++link)
+				{
+					entity_id sphere = registry.create();
+					registry.emplace<spatial3_component>(sphere, top + halfLink + LinkSpacing * math::vector3_f32{ static_cast<f32>(link), 0.0f, 0.0f }, math::quaternion_f32{ 1.0f, 0.0f, 0.0f, 0.0f });
+					registry.emplace<shape_component>(sphere, shape_component::Sphere);
+					registry.emplace<linear_body3_component>(sphere, math::zero3, 2.0f);
+
+					joint_component& joint = registry.emplace<joint_component>(registry.create());
+					joint.type = joint_type::Distance;
+					joint.a = sphere;
+					joint.b = previous;
+					joint.local_anchor_b = previous == null_entity_id ? top : math::zero3;
+					joint.length = previous == null_entity_id ? 0.5f * LinkSpacing : LinkSpacing;
+					previous = sphere;
+				}
+			}
+
+			collision_settings settings;
+			settings.sleep_time = 0.0f;
+			settings.solver.iterations = config.steps;
+			settings.solver.substeps = config.temporal ? config.steps : 0;
+			collision_world world(settings);
+			world.bake_static_bodies(registry);
+
+			const f64 tickTime = timer.Measure([&]()
+				{
+					for (uSize tick = 0; tick < Ticks; ++tick)
+					{
+						simulate(registry, world, TickPeriod);
+					}
+				}) / Ticks;
+
+			f32 stretch = 0.0f;
+			for (auto&& [entity, joint] : registry.view<const joint_component>().each())
+			{
+				stretch = std::max(stretch, std::abs(glm::length(get_joint_anchor(registry, joint.b, joint.local_anchor_b) - get_joint_anchor(registry, joint.a, joint.local_anchor_a)) - joint.length));
+			}
+
+			std::printf("%8zu %8s %8u %8zu %10zu %10zu %12.3f %12.4f\n", config.chains, config.temporal ? "tgs" : "pgs", config.steps, world.solver.get_island_stats().island_count,
+				world.solver.get_row_count(), world.solver.get_color_count(), 1000.0 * tickTime, stretch);
+		}
+		std::printf("\n");
+	}
+
+	//A heap of spheres dropped on an open floor with and without friction. Without it the heap flattens and keeps sliding,
+	//with it the spheres stop where they land and fall asleep, after which a tick costs next to nothing. Spread is the mean
+	//distance of a sphere from the middle of the heap, ticks are timed once the heap has had time to settle.
+	void BenchmarkFriction(BenchmarkTimer& timer)
+	{
+		constexpr f32 TickPeriod = 1.0f / 60.0f;
+		constexpr uSize SettleTicks = 300;
+		constexpr uSize Ticks = 60;
+		constexpr uSize Side = 16;
+		constexpr uSize Layers = 8;
+		constexpr uSize FloorSide = 64; //tiles of two metres, wide enough that the frictionless heap stays on the floor a while
+		constexpr f32 Middle = 1.25f * static_cast<f32>(Side - 1);
+
+		std::printf("Friction, %zu spheres dropped on an open floor and settled for %zu ticks, tick averaged over %zu ticks\n", Side * Side * Layers, SettleTicks, Ticks);
+		std::printf("%10s %8s %8s %10s %10s %12s\n", "friction", "solver", "steps", "sleeping", "spread", "tick [ms]");
+
+		struct configuration
+		{
+			f32 friction;
+			solver_type mode;
+			bool temporal;
+		};
+
+		for (configuration const& config : { configuration{ 0.0f, solver_type::Impulse, false }, configuration{ 0.5f, solver_type::Impulse, false },
+			configuration{ 0.0f, solver_type::Impulse, true }, configuration{ 0.5f, solver_type::Impulse, true },
+			configuration{ 0.0f, solver_type::Xpbd, false }, configuration{ 0.5f, solver_type::Xpbd, false } })
+		{
+			entity_registry registry;
+			for (uSize x = 0; x < FloorSide; ++x)
+			{
+				for (uSize z = 0; z < FloorSide; ++z)
+				{
+					entity_id floor = registry.create();
+					registry.emplace<spatial3_component>(floor, math::vector3_f32{ Middle + 2.0f * (static_cast<f32>(x) - 0.5f * static_cast<f32>(FloorSide)), -1.0f,
+						Middle + 2.0f * (static_cast<f32>(z) - 0.5f * static_cast<f32>(FloorSide)) }, math::quaternion_f32{ 1.0f, 0.0f, 0.0f, 0.0f });
+					registry.emplace<shape_component>(floor, shape_component::Box);
+				}
+			}
+
+			AddColumns(registry, PileLayout(Side, Layers), shape_component::Sphere);
+
+			collision_settings settings;
+			settings.grid_cell_size = 3.0f;
+			settings.solver_mode = config.mode;
+			settings.solver.friction = config.friction;
+			settings.solver.substeps = config.temporal ? settings.solver.iterations : 0;
+			settings.xpbd.friction = config.friction;
+			collision_world world(settings);
+			world.bake_static_bodies(registry);
+			for (uSize tick = 0; tick < SettleTicks; ++tick)
+			{
+				simulate(registry, world, TickPeriod);
+			}
+
+			const f64 tickTime = timer.Measure([&]()
+				{
+					for (uSize tick = 0; tick < Ticks; ++tick)
+					{
+						simulate(registry, world, TickPeriod);
+					}
+				}) / Ticks;
+
+			f64 spread = 0.0;
+			auto spheres = registry.view<const linear_body3_component, const spatial3_component>();
+			for (auto&& [entity, linear, spatial] : spheres.each())
+			{
+				spread += glm::length(math::vector2_f32{ spatial.position.x - Middle, spatial.position.z - Middle });
+			}
+			spread /= static_cast<f64>(Side * Side * Layers);
+
+			const u32 steps = config.mode == solver_type::Xpbd ? settings.xpbd.substeps : settings.solver.iterations;
+			std::printf("%10.2f %8s %8u %10zu %10.2f %12.3f\n", config.friction, config.mode == solver_type::Xpbd ? "xpbd" : config.temporal ? "tgs" : "pgs", steps,
+				registry.storage<sleeping_component>().size(), spread, 1000.0 * tickTime);
+		}
+		std::printf("\n");
+	}
+
+	//a settled pile of unit spheres in columns on static boxes, full ticks timed once the pile has had time to fall asleep
+	void BenchmarkSleeping(BenchmarkTimer& timer)
+	{
+		constexpr f32 TickPeriod = 1.0f / 60.0f;
+		constexpr uSize SettleTicks = 60;
+		constexpr uSize Ticks = 60;
+		constexpr uSize Height = 4;
+
+		std::printf("Sleeping, columns of %zu spheres settled for %zu ticks, tick averaged over %zu ticks\n", Height, SettleTicks, Ticks);
+		std::printf("%8s %8s %10s %10s %12s\n", "spheres", "sleep", "sleeping", "proxies", "tick [ms]");
+
+		for (uSize count : { 16384ull, 102400ull })
+		{
+			for (bool sleep : { false, true })
+			{
+				entity_registry registry;
+				ColumnLayout layout;
+				layout.side = static_cast<uSize>(std::sqrt(static_cast<f64>(count / Height)));
+				layout.layers = Height;
+				AddColumns(registry, layout, shape_component::Sphere);
+
+				collision_settings settings;
+				settings.sleep_time = sleep ? settings.sleep_time : 0.0f;
+				collision_world world(settings);
+				world.bake_static_bodies(registry);
+				for (uSize tick = 0; tick < SettleTicks; ++tick)
+				{
+					integrate(registry, TickPeriod);
+					resolve_collisions(registry, world, TickPeriod);
+				}
+
+				const f64 tickTime = timer.Measure([&]()
+					{
+						for (uSize tick = 0; tick < Ticks; ++tick)
+						{
+							integrate(registry, TickPeriod);
+							resolve_collisions(registry, world, TickPeriod);
+						}
+					}) / Ticks;
+
+				std::printf("%8zu %8s %10zu %10zu %12.3f\n", layout.side * layout.side * Height, sleep ? "on" : "off", registry.storage<sleeping_component>().size(), world.proxies.size(), 1000.0 * tickTime);
+			}
+		}
+		std::printf("\n");
+	}
+}
+
+namespace jm
+{
+	//integrate alone over free bodies, linear only and then with every body spinning under a torque
+	//Integrate with and without a spinning rotational body on every entity. Rotation costs several times the linear step: the
+	//linear step walks the packed awake bodies and is bound by memory, while rotations are a second walk over their own group
+	//that reads and writes a 100 byte rotational body and an orientation looked up through the spatial's sparse set.
+	void BenchmarkRotation(BenchmarkTimer& timer)
+	{
+		constexpr f32 TickPeriod = 1.0f / 60.0f;
+		constexpr uSize Ticks = 100;
+
+		std::printf("Rotation, integrate averaged over %zu ticks\n", Ticks);
+		std::printf("%8s %14s %14s %8s\n", "bodies", "linear [ms]", "rotating [ms]", "ratio");
+
+		for (uSize count : { 10000ull, 100000ull })
+		{
+			f64 tickTimes[2] = {};
+			for (bool rotating : { false, true })
+			{
+				entity_registry registry;
+				for (uSize i = 0; i < count; ++i)
+				{
+					entity_id body = registry.create();
+					registry.emplace<spatial3_component>(body, 100.0f * math::random::unit_ball<f32>(), math::random::unit_quaternion<f32>());
+					registry.emplace<linear_body3_component>(body, math::random::unit_ball<f32>(), 2.0f);
+					if (rotating)
+					{
+						rotational_body3_component& rotational = registry.emplace<rotational_body3_component>(body, math::random::unit_ball<f32>(),
+							make_inertia(shape_component::Box, 2.0f));
+						rotational.applied_torque = math::random::unit_ball<f32>();
+					}
+				}
+
+				integrate(registry, TickPeriod);
+				tickTimes[rotating ? 1 : 0] = timer.Measure([&]()
+					{
+						for (uSize tick = 0; tick < Ticks; ++tick)
+						{
+							integrate(registry, TickPeriod);
+						}
+					}) / Ticks;
+			}
+
+			std::printf("%8zu %14.3f %14.3f %8.2f\n", count, 1000.0 * tickTimes[0], 1000.0 * tickTimes[1], tickTimes[1] / tickTimes[0]);
+		}
+		std::printf("\n");
+	}
+
+	//Linear integration in millions of bodies per second: integrate, which walks the awake bodies packed by their owning
+	//group, against the same step over a view of the bodies, which looks every component up in its pool
+	void BenchmarkIntegration(BenchmarkTimer& timer)
+	{
+		constexpr f32 TickPeriod = 1.0f / 60.0f;
+		constexpr uSize Repeats = 5;
+
+		std::printf("Integration, best of %zu ticks [M bodies/s]\n", Repeats);
+		std::printf("%10s %10s %10s\n", "bodies", "integrate", "view");
+
+		for (uSize count : { 10000ull, 100000ull, 1000000ull })
+		{
+			entity_registry registry;
+			for (uSize i = 0; i < count; ++i)
+			{
+				entity_id body = registry.create();
+				registry.emplace<spatial3_component>(body, 100.0f * math::random::unit_ball<f32>(), math::quaternion_f32{ 1.0f, 0.0f, 0.0f, 0.0f });
+				registry.emplace<linear_body3_component>(body, math::random::unit_ball<f32>(), 2.0f).applied_force = math::random::unit_ball<f32>();
+			}
+
+			const auto bodiesPerSecond = [&](auto&& tick)
+				{
+					f64 best = std::numeric_limits<f64>::max();
+					for (uSize repeat = 0; repeat < Repeats; ++repeat)
+					{
+						best = std::min(best, timer.Measure(tick));
+					}
+					return 1e-6 * static_cast<f64>(count) / best;
+				};
+
+			const f64 integrateRate = bodiesPerSecond([&]() { integrate(registry, TickPeriod); });
+			const f64 viewRate = bodiesPerSecond([&]()
+				{
+					for (auto&& [entity, linear, spatial] : registry.view<linear_body3_component, spatial3_component>(entt::exclude<sleeping_component>).each())
+					{
+						linear.start_position = spatial.position;
+						const math::vector3_f32 acceleration = Gravity + linear.applied_force * linear.inverse_mass;
+						math::semi_implicit_euler::step(spatial.position, linear.velocity, [&acceleration](math::vector3_f32 const&, math::vector3_f32 const&) { return acceleration; },
+							Damping, TickPeriod);
+					}
+				});
+
+			std::printf("%10zu %10.1f %10.1f\n", count, integrateRate, viewRate);
+		}
+		std::printf("\n");
+	}
+
+	//energy of an undamped spring at frequency hertz after a minute of ticks, relative to where it started
+	template <typename Integrator>
+	f64 SpringEnergyDrift(f32 hertz, f32 tickPeriod)
+	{
+		const f32 stiffness = math::two_pi<f32>() * hertz * math::two_pi<f32>() * hertz;
+		const auto energy = [stiffness](math::vector3_f32 const& position, math::vector3_f32 const& velocity)
+			{
+				return 0.5 * static_cast<f64>(glm::dot(velocity, velocity) + stiffness * glm::dot(position, position));
+			};
+
+		math::vector3_f32 position{ 1.0f, 0.0f, 0.0f };
+		math::vector3_f32 velocity{};
+		const f64 startEnergy = energy(position, velocity);
+		const uSize ticks = static_cast<uSize>(60.0f / tickPeriod);
+		for (uSize tick = 0; tick < ticks; ++tick)
+		{
+			Integrator::step(position, velocity, [stiffness](math::vector3_f32 const& at, math::vector3_f32 const&) { return -stiffness * at; }, 1.0f, tickPeriod);
+		}
+		return energy(position, velocity) / startEnergy - 1.0;
+	}
+
+	template <typename Integrator>
+	void BenchmarkIntegrator(BenchmarkTimer& timer, cstring name, entity_registry& registry)
+	{
+		constexpr f32 TickPeriod = 1.0f / 60.0f;
+		constexpr uSize Ticks = 20;
+
+		const f64 tickTime = timer.Measure([&]()
+			{
+				for (uSize tick = 0; tick < Ticks; ++tick)
+				{
+					integrate<Integrator>(registry, TickPeriod);
+				}
+			}) / Ticks;
+
+		std::printf("%22s", name);
+		for (f32 hertz : { 1.0f, 5.0f, 10.0f })
+		{
+			const f64 drift = SpringEnergyDrift<Integrator>(hertz, TickPeriod);
+			if (std::isfinite(drift))
+			{
+				std::printf(" %12.2e", drift);
+			}
+			else
+			{
+				std::printf(" %12s", "diverged");
+			}
+		}
+		std::printf(" %12.3f\n", 1000.0 * tickTime);
+	}
+
+	//Each integrator policy: the relative energy change of an undamped spring over a minute at 60 Hz, positive is gained,
+	//and the cost of integrate on the registry. Forces in the world are constant over a step, where velocity Verlet and
+	//Runge-Kutta are exact, so springs are what tell the schemes apart.
+	void BenchmarkIntegrators(BenchmarkTimer& timer)
+	{
+		constexpr uSize Count = 100000;
+
+		std::printf("Integrators, spring energy drift over 60 s at 60 Hz and integrate on %zu bodies\n", Count);
+		std::printf("%22s %12s %12s %12s %12s\n", "integrator", "1 Hz", "5 Hz", "10 Hz", "tick [ms]");
+
+		entity_registry registry;
+		for (uSize i = 0; i < Count; ++i)
+		{
+			entity_id body = registry.create();
+			registry.emplace<spatial3_component>(body, 100.0f * math::random::unit_ball<f32>(), math::quaternion_f32{ 1.0f, 0.0f, 0.0f, 0.0f });
+			registry.emplace<linear_body3_component>(body, math::random::unit_ball<f32>(), 2.0f).applied_force = math::random::unit_ball<f32>();
+		}
+
+		BenchmarkIntegrator<math::explicit_euler>(timer, "explicit euler", registry);
+		BenchmarkIntegrator<math::semi_implicit_euler>(timer, "semi-implicit euler", registry);
+		BenchmarkIntegrator<math::velocity_verlet>(timer, "velocity verlet", registry);
+		BenchmarkIntegrator<math::runge_kutta4>(timer, "runge-kutta 4", registry);
+		std::printf("\n");
+	}
+}
+
+int main()
+{
+	jm::BenchmarkTimer timer;
+	jm::BenchmarkBroadphasePairs(timer);
+	jm::BenchmarkParallelGrid(timer);
+	jm::BenchmarkCoherentMotion(timer);
+	jm::BenchmarkMixedSizes(timer);
+	jm::BenchmarkBoxBox(timer);
+	jm::BenchmarkSphereBatch(timer);
+	jm::BenchmarkStacking(timer);
+	jm::BenchmarkColoring(timer);
+	jm::BenchmarkXpbd(timer);
+	jm::BenchmarkJoints(timer);
+	jm::BenchmarkFriction(timer);
+	jm::BenchmarkSleeping(timer);
+	jm::BenchmarkRotation(timer);
+	jm::BenchmarkIntegration(timer);
+	jm::BenchmarkIntegrators(timer);
+	return 0;
+}
@@ -10,11 +10,14 @@
 #include "Systems/Graphics.h"
 #include "Systems/Components.h"
 #include "Systems/Simulation.h"
+#include "Systems/Collision.h"
 
 #include "DearImGui/imgui.h"
 
 #include "World.h"
 
+#include <cmath>
+
 namespace jm
 {
 	constexpr math::vector2<iSize> screenSize = { 1600, 900 };
@@ -22,8 +25,9 @@ namespace jm
 
 	struct LoopController final
 	{
-		static constexpr uSize FixedTick_Frequency = 120; //Hz
+		static constexpr uSize FixedTick_Frequency = 60; //Hz, fast bodies use continuous collision rather than a higher rate
 		static constexpr f64 FixedTick_Period = 1.0 / FixedTick_Frequency; //s
+		static constexpr uSize FixedTick_MaxPerFrame = 4; //ticks a slow frame catches up at most, time past that is dropped
 
 		static constexpr uSize FPSUpdate_Frequency = 4; //Hz
 		static constexpr f64 FPSUpdate_Period = 1.0 / FPSUpdate_Frequency; //s
@@ -33,7 +37,9 @@ namespace jm
 			Timer.Initialize();
 		}
 
-		void Step()
+		//Counts the ticks owed for the time since the last frame. While not simulating the owed time stays where it is, so the
+		//interpolation does not move and resuming picks up from the same pose.
+		void Step(bool simulating)
 		{
 			Timer.Update();
 			FPSCounter++;
@@ -47,17 +53,23 @@ namespace jm
 				FPSCounter = 0;
 			}
 
+			TicksThisFrame = 0;
+			if (!simulating)
+			{
+				return;
+			}
+
 			SimUpdateAccumulator += dt;
-			if (SimUpdateAccumulator > FixedTick_Period)
+			while (SimUpdateAccumulator >= FixedTick_Period && TicksThisFrame < FixedTick_MaxPerFrame)
 			{
 				SimUpdateAccumulator -= FixedTick_Period;
-				ShouldTick = true;
+				TicksThisFrame++;
 			}
-			else
+			if (SimUpdateAccumulator >= FixedTick_Period)
 			{
-				ShouldTick = false;
+				//owing the rest would make the next frame slower still, the simulation runs slow instead
+				SimUpdateAccumulator = std::fmod(SimUpdateAccumulator, FixedTick_Period);
 			}
-
 		}
 
 		f32 GetLoopDeltaTime()
@@ -70,9 +82,15 @@ namespace jm
 			return FPS;
 		}
 
-		bool ShouldTickThisFrame()
+		uSize GetTicksThisFrame()
 		{
-			return ShouldTick;
+			return TicksThisFrame;
+		}
+
+		//how far the time since the last tick is into the next one, to draw bodies that far from their previous pose
+		f32 GetInterpolation()
+		{
+			return static_cast<f32>(SimUpdateAccumulator / FixedTick_Period);
 		}
 
 	private:
@@ -82,7 +100,7 @@ namespace jm
 		f64 FPSUpdateAccumulator = 0.0;
 		uSize FPSCounter = 0;
 		uSize FPS = 60;
-		bool ShouldTick = false;
+		uSize TicksThisFrame = 0;
 	};
 
 	math::camera3<f32> Make3DCamera(f32 distanceFromOrigin, f32 yFOV, f32 aspectRatio)
@@ -124,17 +142,17 @@ namespace jm
 
 		virtual void RunLoop() override
 		{
-			Controller.Step();
+			Controller.Step(Simulating);
 
 			InputUpdate();
 
-			if (Simulating && Controller.ShouldTickThisFrame())
+			for (uSize tick = 0; tick < Controller.GetTicksThisFrame(); ++tick)
 			{
 				SimulationUpdate();
 			}
 
 			uSize fps = Controller.GetFPS();
-			GraphicsSystem.Draw3D(Camera, [this, fps]()
+			GraphicsSystem.Draw3D(Camera, Controller.GetInterpolation(), [this, fps]()
 				{
 					ImGui::Begin("Data");
 					ImGui::Text("FPS = %d", fps);
@@ -158,6 +176,52 @@ namespace jm
 
 					GraphicsSystem.ImGuiDebug();
 
+					ImGui::Text("Collision");
+					int broadphase = static_cast<int>(Collision.settings.broadphase);
+					if (ImGui::Combo("Broadphase", &broadphase, "Brute Force\0Uniform Grid\0Sweep and Prune\0Dynamic Tree\0"))
+					{
+						Collision.set_broadphase(static_cast<broadphase_type>(broadphase));
+					}
+					int solverMode = static_cast<int>(Collision.settings.solver_mode);
+					if (ImGui::Combo("Solver", &solverMode, "Impulse\0XPBD\0"))
+					{
+						Collision.settings.solver_mode = static_cast<solver_type>(solverMode);
+					}
+					int substeps = static_cast<int>(Collision.settings.solver.substeps);
+					if (ImGui::SliderInt("Impulse substeps", &substeps, 0, 16))
+					{
+						Collision.settings.solver.substeps = static_cast<u32>(substeps);
+					}
+					if (ImGui::SliderFloat("Friction", &Collision.settings.solver.friction, 0.0f, 1.0f))
+					{
+						Collision.settings.xpbd.friction = Collision.settings.solver.friction;
+					}
+					ImGui::SliderFloat("Rolling resistance", &Collision.settings.solver.rolling_resistance, 0.0f, 0.2f);
+					broadphase_stats const& broadphaseStats = Collision.pair_finder->get_stats();
+					ImGui::Text("Proxies = %zu", broadphaseStats.proxies);
+					ImGui::Text("Tested pairs = %zu", broadphaseStats.tested_pairs);
+					ImGui::Text("Candidate pairs = %zu", broadphaseStats.candidate_pairs);
+					ImGui::Text("Filtered pairs = %zu", broadphaseStats.filtered_pairs);
+					ImGui::Text("Static proxies = %zu", Collision.static_stats.proxies);
+					ImGui::Text("Static pairs = %zu", Collision.static_stats.candidate_pairs);
+					ImGui::Text("Static filtered pairs = %zu", Collision.static_stats.filtered_pairs);
+					ImGui::Text("Contacts begin/persist/end = %zu/%zu/%zu", Collision.contact_events.begin.size(), Collision.contact_events.persist.size(), Collision.contact_events.end.size());
+					ImGui::Text("Warm started points = %zu", Collision.warm_started_points);
+					ImGui::Text("Continuous impacts = %zu", Collision.continuous_impacts);
+					ImGui::Text("Sleeping/woken bodies = %zu/%zu", registry.storage<sleeping_component>().size(), Collision.woken_bodies);
+					ImGui::Text("Solver bodies/rows/joint rows/colours = %zu/%zu/%zu/%zu", Collision.solver.get_body_count(), Collision.solver.get_row_count(), Collision.solver.get_joint_row_count(), Collision.solver.get_color_count());
+					ImGui::Text("XPBD bodies/constraints/joints = %zu/%zu/%zu", Collision.xpbd.get_body_count(), Collision.xpbd.get_constraint_count(), Collision.xpbd.get_joint_count());
+					island_stats const& islands = Collision.solver.get_island_stats();
+					ImGui::Text("Islands = %zu, largest = %zu", islands.island_count, islands.largest_island);
+					if (ImGui::TreeNode("Island sizes"))
+					{
+						for (uSize bucket = 0; bucket < islands.size_histogram.size(); ++bucket)
+						{
+							ImGui::Text("%zu+ bodies = %zu", uSize(1) << bucket, islands.size_histogram[bucket]);
+						}
+						ImGui::TreePop();
+					}
+
 					ImGui::Text("Entities");
 					ImGui::Text("Count = %d", registry.storage<entity_id>().in_use());
 					/*if (SelectedEntity.has_value())
@@ -190,11 +254,13 @@ namespace jm
 		void CreateWorld()
 		{
 			CreateBasicWorld(registry);
+			Collision.bake_static_bodies(registry);
 		}
 
 		void DestroyWorld()
 		{
 			registry.clear();
+			Collision = collision_world(Collision.settings);
 		}
 
 		void InputUpdate()
@@ -241,10 +307,11 @@ namespace jm
 
 		void SimulationUpdate()
 		{
-			integrate(registry, static_cast<f32>(LoopController::FixedTick_Period));
+			simulate(registry, Collision, static_cast<f32>(LoopController::FixedTick_Period));
 		}
 
 		entity_registry registry;
+		collision_world Collision;
 		LoopController Controller;
 		bool Simulating = false;
 
@@ -2,6 +2,7 @@
 
 #include "Systems/Entity.h"
 #include "Systems/Components.h"
+#include "Systems/Shapes.h"
 
 #include "Random.h"
 
@@ -10,9 +11,11 @@ namespace jm
 	void AddSphereEntity(entity_registry& registry, math::vector3_f32 const& position, math::quaternion_f32 const& rotation)
 	{
 		entity_id e = registry.create();
-		registry.emplace<spatial3_component>(e,position, rotation);
+		spatial3_component const& spatial = registry.emplace<spatial3_component>(e,position, rotation);
+		registry.emplace<previous_spatial3_component>(e, spatial);
 		registry.emplace<shape_component>(e, shape_component::Sphere);
 		registry.emplace<linear_body3_component>(e, math::zero3, 2.f);
+		registry.emplace<rotational_body3_component>(e, math::zero3, make_inertia(shape_component::Sphere, 2.f));
 	}
 
 	void AddBoxEntity(entity_registry& registry, math::vector3_f32 const& position, math::quaternion_f32 const& rotation, math::vector3_f32 const& extents = math::zero3)
@@ -23,6 +26,31 @@ namespace jm
 		registry.emplace<shape_component>(e, shape_component::Box);
 	}
 
+	//a chain of spheres on distance joints held out level from a point in the world, the gap between links keeps neighbours from colliding
+	void AddChain(entity_registry& registry, math::vector3_f32 const& top, uSize links)
+	{
+		constexpr f32 LinkSpacing = 2.5f;
+		const math::vector3_f32 halfLink = { 0.5f * LinkSpacing, 0.0f, 0.0f };
+
+		entity_id previous = null_entity_id;
+		for (uSize link = 0; link < links; ++link)
+		{
+			entity_id e = registry.create();
+			spatial3_component const& spatial = registry.emplace<spatial3_component>(e, top + halfLink + LinkSpacing * math::vector3_f32{ f32(link), 0.0f, 0.0f }, math::quaternion_f32{ 1.0f, 0.0f, 0.0f, 0.0f });
+			registry.emplace<previous_spatial3_component>(e, spatial);
+			registry.emplace<shape_component>(e, shape_component::Sphere);
+			registry.emplace<linear_body3_component>(e, math::zero3, 2.f);
+
+			joint_component& joint = registry.emplace<joint_component>(registry.create());
+			joint.type = joint_type::Distance;
+			joint.a = e;
+			joint.b = previous;
+			joint.local_anchor_b = previous == null_entity_id ? top : math::zero3;
+			joint.length = previous == null_entity_id ? 0.5f * LinkSpacing : LinkSpacing;
+			previous = e;
+		}
+	}
+
 	void CreateBasicWorld(entity_registry& registry)
 	{
 		AddSphereEntity(registry, 8.0f * math::random::unit_ball<f32>(), math::random::unit_quaternion<f32>());
@@ -33,5 +61,7 @@ namespace jm
 		AddBoxEntity(registry, 8.0f * math::random::unit_ball<f32>(), math::random::unit_quaternion<f32>());
 		AddBoxEntity(registry, 8.0f * math::random::unit_ball<f32>(), math::random::unit_quaternion<f32>());
 		AddBoxEntity(registry, 8.0f * math::random::unit_ball<f32>(), math::random::unit_quaternion<f32>());
+
+		AddChain(registry, { -6.0f, 10.0f, 0.0f }, 6);
 	}
 }
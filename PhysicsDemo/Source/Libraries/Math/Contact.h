@@ -0,0 +1,617 @@
+#pragma once
+
+#include "Geometry.h"
+
+#include <array>
+
+namespace jm::math
+{
+    template <typename T>
+    struct contact_point3
+    {
+        vector3<T> position{}; //halfway between the two surfaces
+        T depth{}; //penetration along the manifold normal, positive when overlapping
+        u32 feature = 0; //identifies the pair of features that made the point, stable while the contact persists
+
+        //accumulated by the solver and carried to the matching point next update so it can warm start
+        T normal_impulse{};
+        vector2<T> tangent_impulse{};
+        vector3<T> tangent{}; //tangent_impulse is along this and cross(normal, tangent), zero until the solver picks it
+        vector2<T> rolling_impulse{}; //turning about the same two directions
+    };
+
+    template <typename T>
+    struct contact_manifold3
+    {
+        static constexpr u32 MaxPoints = 4;
+
+        vector3<T> normal{}; //unit length, points from a to b
+        std::array<contact_point3<T>, MaxPoints> points{};
+        u32 point_count = 0;
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        struct clip_vertex
+        {
+            vector3<T> position;
+            u32 feature;
+        };
+
+        template <typename T>
+        using clip_polygon = std::array<clip_vertex<T>, 8>; //a quad clipped by four planes gains at most four vertices
+
+        //Sutherland-Hodgman against dot(normal, p) <= offset, new vertices remember which plane and edge cut them
+        template <typename T>
+        u32 clip(clip_polygon<T> const& in, u32 in_count, vector3<T> const& normal, T offset, u32 plane, clip_polygon<T>& out)
+        {
+            u32 out_count = 0;
+            for (u32 idx = 0; idx < in_count; ++idx)
+            {
+                clip_vertex<T> const& a = in[idx];
+                clip_vertex<T> const& b = in[(idx + 1) % in_count];
+                const T distance_a = dot(normal, a.position) - offset;
+                const T distance_b = dot(normal, b.position) - offset;
+
+                if (distance_a <= T(0))
+                {
+                    out[out_count++] = a;
+                }
+                //the same inside test as above, a vertex on the plane must not also count as a crossing or the polygon overflows
+                if ((distance_a <= T(0)) != (distance_b <= T(0)))
+                {
+                    const T t = distance_a / (distance_a - distance_b);
+                    out[out_count++] = { a.position + t * (b.position - a.position), 16 + plane * 4 + (a.feature & 3) };
+                }
+            }
+            return out_count;
+        }
+
+        //keeps the deepest point, the one farthest from it, then the two spanning the most area either side of that edge
+        template <typename T>
+        void reduce_manifold(std::array<contact_point3<T>, 8> const& candidates, u32 count, vector3<T> const& normal, contact_manifold3<T>& manifold)
+        {
+            if (count <= contact_manifold3<T>::MaxPoints)
+            {
+                std::copy_n(candidates.begin(), count, manifold.points.begin());
+                manifold.point_count = count;
+                return;
+            }
+
+            u32 first = 0;
+            for (u32 idx = 1; idx < count; ++idx)
+            {
+                if (candidates[idx].depth > candidates[first].depth)
+                {
+                    first = idx;
+                }
+            }
+
+            u32 second = first == 0 ? 1 : 0;
+            T best = T(-1);
+            for (u32 idx = 0; idx < count; ++idx)
+            {
+                const vector3<T> offset = candidates[idx].position - candidates[first].position;
+                if (idx != first && dot(offset, offset) > best)
+                {
+                    best = dot(offset, offset);
+                    second = idx;
+                }
+            }
+
+            const vector3<T> edge = candidates[second].position - candidates[first].position;
+            u32 third = first;
+            u32 fourth = first;
+            T max_area = T(0);
+            T min_area = T(0);
+            for (u32 idx = 0; idx < count; ++idx)
+            {
+                const T area = dot(cross(edge, candidates[idx].position - candidates[first].position), normal);
+                if (area > max_area)
+                {
+                    max_area = area;
+                    third = idx;
+                }
+                if (area < min_area)
+                {
+                    min_area = area;
+                    fourth = idx;
+                }
+            }
+
+            manifold.point_count = 0;
+            for (u32 idx : { first, second, third, fourth })
+            {
+                if (idx != first || manifold.point_count == 0)
+                {
+                    manifold.points[manifold.point_count++] = candidates[idx];
+                }
+            }
+        }
+
+        //clips the incident face of box i against the side planes of face axis of box r, normal points from r to i
+        template <typename T>
+        void face_contact(box3<T> const& r, glm::length_t axis, vector3<T> const& normal, box3<T> const& i, u32 feature_base, contact_manifold3<T>& manifold)
+        {
+            //incident face is the one on i most opposed to the reference normal
+            glm::length_t incident_axis = 0;
+            T incident_alignment = T(0);
+            for (glm::length_t k = 0; k < 3; ++k)
+            {
+                const T alignment = dot(normal, i.axes[k]);
+                if (std::abs(alignment) > std::abs(incident_alignment))
+                {
+                    incident_alignment = alignment;
+                    incident_axis = k;
+                }
+            }
+
+            const T incident_sign = incident_alignment > T(0) ? T(-1) : T(1);
+            const glm::length_t u = (incident_axis + 1) % 3;
+            const glm::length_t v = (incident_axis + 2) % 3;
+            const vector3<T> face_center = i.position + incident_sign * i.extents[incident_axis] * i.axes[incident_axis];
+            const vector3<T> half_u = i.extents[u] * i.axes[u];
+            const vector3<T> half_v = i.extents[v] * i.axes[v];
+
+            clip_polygon<T> polygon;
+            polygon[0] = { face_center + half_u + half_v, 0 };
+            polygon[1] = { face_center - half_u + half_v, 1 };
+            polygon[2] = { face_center - half_u - half_v, 2 };
+            polygon[3] = { face_center + half_u - half_v, 3 };
+            u32 count = 4;
+
+            //the four side planes of the reference face
+            clip_polygon<T> clipped;
+            u32 plane = 0;
+            for (glm::length_t side : { (axis + 1) % 3, (axis + 2) % 3 })
+            {
+                const vector3<T> side_normal = r.axes[side];
+                const T center_offset = dot(side_normal, r.position);
+                count = clip(polygon, count, side_normal, center_offset + r.extents[side], plane++, clipped);
+                count = clip(clipped, count, -side_normal, -center_offset + r.extents[side], plane++, polygon);
+            }
+
+            const T face_offset = dot(normal, r.position) + r.extents[axis];
+            const u32 face_feature = feature_base | u32(incident_axis * 2 + (incident_sign > T(0) ? 1 : 0)) << 8;
+
+            std::array<contact_point3<T>, 8> candidates;
+            u32 candidate_count = 0;
+            for (u32 idx = 0; idx < count; ++idx)
+            {
+                const T separation = dot(normal, polygon[idx].position) - face_offset;
+                if (separation <= T(0))
+                {
+                    candidates[candidate_count++] = { polygon[idx].position - T(0.5) * separation * normal, -separation, face_feature | polygon[idx].feature };
+                }
+            }
+
+            reduce_manifold(candidates, candidate_count, normal, manifold);
+        }
+
+        //sphere of radius against box b given its centre in the frame of b, normal points from the sphere to the box.
+        //Features are the 27 regions around the box while the centre is outside, then the face it is pushed out of.
+        template <typename T>
+        bool sphere_box_contact(vector3<T> const& local_center, T radius, box3<T> const& b, contact_manifold3<T>& manifold)
+        {
+            const vector3<T> clamped = glm::clamp(local_center, -b.extents, b.extents);
+            const vector3<T> offset = clamped - local_center;
+            const T distance_squared = dot(offset, offset);
+            if (distance_squared > radius * radius)
+            {
+                manifold.point_count = 0;
+                return false;
+            }
+
+            vector3<T> local_normal;
+            vector3<T> local_surface;
+            T depth;
+            u32 feature = 0;
+            if (distance_squared > math::epsilon<T>() * math::epsilon<T>())
+            {
+                const T distance = std::sqrt(distance_squared);
+                local_normal = offset / distance;
+                local_surface = clamped;
+                depth = radius - distance;
+                for (glm::length_t axis = 2; axis >= 0; --axis)
+                {
+                    feature = feature * 3 + (local_center[axis] < -b.extents[axis] ? 0 : local_center[axis] > b.extents[axis] ? 2 : 1);
+                }
+            }
+            else
+            {
+                //centre inside the box, push out through the nearest face
+                glm::length_t axis = 0;
+                for (glm::length_t i = 1; i < 3; ++i)
+                {
+                    if (b.extents[i] - std::abs(local_center[i]) < b.extents[axis] - std::abs(local_center[axis]))
+                    {
+                        axis = i;
+                    }
+                }
+
+                const T sign = local_center[axis] < T(0) ? T(-1) : T(1);
+                local_normal = vector3<T>(T(0));
+                local_normal[axis] = -sign;
+                local_surface = local_center;
+                local_surface[axis] = sign * b.extents[axis];
+                depth = radius + b.extents[axis] - std::abs(local_center[axis]);
+                feature = 27 + u32(axis) * 2 + (sign > T(0) ? 1 : 0);
+            }
+
+            manifold.normal = b.axes * local_normal;
+            manifold.points[0] = { b.position + b.axes * (local_surface + local_normal * (T(0.5) * depth)), depth, feature };
+            manifold.point_count = 1;
+            return true;
+        }
+
+        //the edge of b, parallel to axis, that lies farthest along direction
+        template <typename T>
+        vector3<T> support_edge_center(box3<T> const& b, glm::length_t axis, vector3<T> const& direction, u32& edge)
+        {
+            vector3<T> result = b.position;
+            edge = 0;
+            for (glm::length_t k = 1; k < 3; ++k)
+            {
+                const glm::length_t other = (axis + k) % 3;
+                const bool positive = dot(direction, b.axes[other]) > T(0);
+                result += (positive ? b.extents[other] : -b.extents[other]) * b.axes[other];
+                edge |= positive ? 1u << (k - 1) : 0u;
+            }
+            return result;
+        }
+    }
+
+    //Separating axis test for two oriented boxes over the 15 candidate axes, using the axes already stored on each box.
+    //Face axes are preferred over edge axes unless clearly better, so resting contacts keep a stable face manifold.
+    template <typename T>
+    bool collide(box3<T> const& a, box3<T> const& b, contact_manifold3<T>& manifold)
+    {
+        constexpr T ParallelTolerance = T(1e-5);
+        constexpr T RelativeTolerance = T(0.95);
+        const T absolute_tolerance = T(0.01) * std::max(std::max(std::max(a.extents.x, a.extents.y), a.extents.z), std::max(std::max(b.extents.x, b.extents.y), b.extents.z));
+
+        manifold.point_count = 0;
+
+        //rotation of b in the frame of a, padded so near parallel edges do not produce a zero length cross product
+        matrix33<T> c;
+        matrix33<T> abs_c;
+        bool parallel = false;
+        for (glm::length_t i = 0; i < 3; ++i)
+        {
+            for (glm::length_t j = 0; j < 3; ++j)
+            {
+                c[i][j] = dot(a.axes[i], b.axes[j]);
+                abs_c[i][j] = std::abs(c[i][j]) + ParallelTolerance;
+                parallel = parallel || abs_c[i][j] >= T(1);
+            }
+        }
+
+        const vector3<T> displacement = b.position - a.position;
+        const vector3<T> da{ dot(displacement, a.axes[0]), dot(displacement, a.axes[1]), dot(displacement, a.axes[2]) };
+        const vector3<T> db{ dot(displacement, b.axes[0]), dot(displacement, b.axes[1]), dot(displacement, b.axes[2]) };
+
+        T a_separation = -infinity<T>();
+        glm::length_t a_axis = 0;
+        for (glm::length_t i = 0; i < 3; ++i)
+        {
+            const T separation = std::abs(da[i]) - (a.extents[i] + abs_c[i][0] * b.extents[0] + abs_c[i][1] * b.extents[1] + abs_c[i][2] * b.extents[2]);
+            if (separation > T(0))
+            {
+                return false;
+            }
+            if (separation > a_separation)
+            {
+                a_separation = separation;
+                a_axis = i;
+            }
+        }
+
+        T b_separation = -infinity<T>();
+        glm::length_t b_axis = 0;
+        for (glm::length_t j = 0; j < 3; ++j)
+        {
+            const T separation = std::abs(db[j]) - (b.extents[j] + abs_c[0][j] * a.extents[0] + abs_c[1][j] * a.extents[1] + abs_c[2][j] * a.extents[2]);
+            if (separation > T(0))
+            {
+                return false;
+            }
+            if (separation > b_separation)
+            {
+                b_separation = separation;
+                b_axis = j;
+            }
+        }
+
+        //edge axes only matter when no two edges are parallel, otherwise a face axis already separates
+        T edge_separation = -infinity<T>();
+        glm::length_t edge_a = 0;
+        glm::length_t edge_b = 0;
+        if (!parallel)
+        {
+            for (glm::length_t i = 0; i < 3; ++i)
+            {
+                const glm::length_t i1 = (i + 1) % 3;
+                const glm::length_t i2 = (i + 2) % 3;
+                for (glm::length_t j = 0; j < 3; ++j)
+                {
+                    const glm::length_t j1 = (j + 1) % 3;
+                    const glm::length_t j2 = (j + 2) % 3;
+
+                    const T distance = std::abs(da[i2] * c[i1][j] - da[i1] * c[i2][j]);
+                    const T radius = a.extents[i1] * abs_c[i2][j] + a.extents[i2] * abs_c[i1][j] + b.extents[j1] * abs_c[i][j2] + b.extents[j2] * abs_c[i][j1];
+                    const T separation = (distance - radius) / std::sqrt(T(1) - c[i][j] * c[i][j]);
+                    if (separation > T(0))
+                    {
+                        return false;
+                    }
+                    if (separation > edge_separation)
+                    {
+                        edge_separation = separation;
+                        edge_a = i;
+                        edge_b = j;
+                    }
+                }
+            }
+        }
+
+        if (edge_separation > RelativeTolerance * std::max(a_separation, b_separation) + absolute_tolerance)
+        {
+            vector3<T> normal = normalize(cross(a.axes[edge_a], b.axes[edge_b]));
+            if (dot(normal, displacement) < T(0))
+            {
+                normal = -normal;
+            }
+
+            u32 a_edge = 0;
+            u32 b_edge = 0;
+            const vector3<T> a_center = detail::support_edge_center(a, edge_a, normal, a_edge);
+            const vector3<T> b_center = detail::support_edge_center(b, edge_b, -normal, b_edge);
+
+            //closest points between the two edge lines, clamped to the edges
+            const vector3<T> a_direction = a.axes[edge_a];
+            const vector3<T> b_direction = b.axes[edge_b];
+            const vector3<T> offset = a_center - b_center;
+            const T alignment = dot(a_direction, b_direction);
+            const T denominator = T(1) - alignment * alignment;
+            const T s = std::clamp((alignment * dot(b_direction, offset) - dot(a_direction, offset)) / denominator, -a.extents[edge_a], a.extents[edge_a]);
+            const T t = std::clamp(dot(b_direction, offset) + alignment * s, -b.extents[edge_b], b.extents[edge_b]);
+
+            const vector3<T> a_point = a_center + s * a_direction;
+            const vector3<T> b_point = b_center + t * b_direction;
+
+            manifold.normal = normal;
+            manifold.points[0] = { T(0.5) * (a_point + b_point), -edge_separation, 1u << 31 | u32(edge_a * 3 + edge_b) << 8 | a_edge << 2 | b_edge };
+            manifold.point_count = 1;
+        }
+        else if (b_separation > RelativeTolerance * a_separation + absolute_tolerance)
+        {
+            const vector3<T> normal = db[b_axis] > T(0) ? -b.axes[b_axis] : b.axes[b_axis];
+            detail::face_contact(b, b_axis, normal, a, u32(6 + b_axis * 2 + (db[b_axis] > T(0) ? 1 : 0)) << 16, manifold);
+            manifold.normal = -normal;
+        }
+        else
+        {
+            const vector3<T> normal = da[a_axis] < T(0) ? -a.axes[a_axis] : a.axes[a_axis];
+            detail::face_contact(a, a_axis, normal, b, u32(a_axis * 2 + (da[a_axis] < T(0) ? 1 : 0)) << 16, manifold);
+            manifold.normal = normal;
+        }
+
+        return manifold.point_count != 0;
+    }
+
+    //Batched over pairs a[i], b[i]. The six face axes are tested first for a block of pairs at a time, laid out one pair
+    //per lane so the loops vectorise, which rejects most separated pairs without the edge tests or any branching.
+    //Full manifolds are then built only for the survivors. Separated pairs get an empty manifold, returns the touching count.
+    template <typename T>
+    uSize collide(std::vector<box3<T>> const& a, std::vector<box3<T>> const& b, std::vector<contact_manifold3<T>>& manifolds)
+    {
+        constexpr uSize Lanes = 8;
+
+        JM_MATH_ASSERT(a.size() == b.size());
+        manifolds.resize(a.size());
+
+        uSize touching = 0;
+        for (uSize base = 0; base < a.size(); base += Lanes)
+        {
+            T a_axes[3][3][Lanes];
+            T b_axes[3][3][Lanes];
+            T a_extents[3][Lanes];
+            T b_extents[3][Lanes];
+            T displacement[3][Lanes];
+            for (uSize lane = 0; lane < Lanes; ++lane)
+            {
+                //the last block repeats its final pair in the unused lanes
+                const uSize idx = std::min(base + lane, a.size() - 1);
+                for (glm::length_t i = 0; i < 3; ++i)
+                {
+                    for (glm::length_t k = 0; k < 3; ++k)
+                    {
+                        a_axes[i][k][lane] = a[idx].axes[i][k];
+                        b_axes[i][k][lane] = b[idx].axes[i][k];
+                    }
+                    a_extents[i][lane] = a[idx].extents[i];
+                    b_extents[i][lane] = b[idx].extents[i];
+                    displacement[i][lane] = b[idx].position[i] - a[idx].position[i];
+                }
+            }
+
+            T abs_c[3][3][Lanes];
+            T da[3][Lanes];
+            T db[3][Lanes];
+            for (uSize i = 0; i < 3; ++i)
+            {
+                for (uSize lane = 0; lane < Lanes; ++lane)
+                {
+                    da[i][lane] = displacement[0][lane] * a_axes[i][0][lane] + displacement[1][lane] * a_axes[i][1][lane] + displacement[2][lane] * a_axes[i][2][lane];
+                    db[i][lane] = displacement[0][lane] * b_axes[i][0][lane] + displacement[1][lane] * b_axes[i][1][lane] + displacement[2][lane] * b_axes[i][2][lane];
+                }
+                for (uSize j = 0; j < 3; ++j)
+                {
+                    for (uSize lane = 0; lane < Lanes; ++lane)
+                    {
+                        abs_c[i][j][lane] = std::abs(a_axes[i][0][lane] * b_axes[j][0][lane] + a_axes[i][1][lane] * b_axes[j][1][lane] + a_axes[i][2][lane] * b_axes[j][2][lane]);
+                    }
+                }
+            }
+
+            u32 separated[Lanes] = {};
+            for (uSize i = 0; i < 3; ++i)
+            {
+                for (uSize lane = 0; lane < Lanes; ++lane)
+                {
+                    const T a_radius = a_extents[i][lane] + abs_c[i][0][lane] * b_extents[0][lane] + abs_c[i][1][lane] * b_extents[1][lane] + abs_c[i][2][lane] * b_extents[2][lane];
+                    const T b_radius = b_extents[i][lane] + abs_c[0][i][lane] * a_extents[0][lane] + abs_c[1][i][lane] * a_extents[1][lane] + abs_c[2][i][lane] * a_extents[2][lane];
+                    separated[lane] |= (std::abs(da[i][lane]) > a_radius ? 1u : 0u) | (std::abs(db[i][lane]) > b_radius ? 1u : 0u);
+                }
+            }
+
+            for (uSize lane = 0; lane < Lanes && base + lane < a.size(); ++lane)
+            {
+                const uSize idx = base + lane;
+                manifolds[idx].point_count = 0;
+                if (separated[lane] == 0)
+                {
+                    touching += collide(a[idx], b[idx], manifolds[idx]) ? 1 : 0;
+                }
+            }
+        }
+        return touching;
+    }
+
+    //exact test against the closest point on the box, the manifold has a single point and its normal points from a to b
+    template <typename T>
+    bool collide(sphere3<T> const& a, box3<T> const& b, contact_manifold3<T>& manifold)
+    {
+        return detail::sphere_box_contact(glm::transpose(b.axes) * (a.center - b.position), a.radius, b, manifold);
+    }
+
+    template <typename T>
+    bool collide(box3<T> const& a, sphere3<T> const& b, contact_manifold3<T>& manifold)
+    {
+        const bool touching = collide(b, a, manifold);
+        manifold.normal = -manifold.normal;
+        return touching;
+    }
+
+    //Batched over many spheres against one box. The centres of a block of spheres are moved into the frame of the box one
+    //sphere per lane so the transform and the distance rejection vectorise, contacts are then built only for the survivors.
+    //Separated spheres get an empty manifold, normals point from the sphere to the box, returns the touching count.
+    template <typename T>
+    uSize collide(std::vector<sphere3<T>> const& a, box3<T> const& b, std::vector<contact_manifold3<T>>& manifolds)
+    {
+        constexpr uSize Lanes = 8;
+
+        manifolds.resize(a.size());
+
+        uSize touching = 0;
+        for (uSize base = 0; base < a.size(); base += Lanes)
+        {
+            T displacement[3][Lanes];
+            T radius[Lanes];
+            for (uSize lane = 0; lane < Lanes; ++lane)
+            {
+                //the last block repeats its final sphere in the unused lanes
+                const uSize idx = std::min(base + lane, a.size() - 1);
+                for (glm::length_t i = 0; i < 3; ++i)
+                {
+                    displacement[i][lane] = a[idx].center[i] - b.position[i];
+                }
+                radius[lane] = a[idx].radius;
+            }
+
+            T local_center[3][Lanes];
+            T distance_squared[Lanes] = {};
+            for (glm::length_t i = 0; i < 3; ++i)
+            {
+                for (uSize lane = 0; lane < Lanes; ++lane)
+                {
+                    local_center[i][lane] = displacement[0][lane] * b.axes[i][0] + displacement[1][lane] * b.axes[i][1] + displacement[2][lane] * b.axes[i][2];
+                    const T outside = std::max(std::abs(local_center[i][lane]) - b.extents[i], T(0));
+                    distance_squared[lane] += outside * outside;
+                }
+            }
+
+            for (uSize lane = 0; lane < Lanes && base + lane < a.size(); ++lane)
+            {
+                const uSize idx = base + lane;
+                manifolds[idx].point_count = 0;
+                if (distance_squared[lane] <= radius[lane] * radius[lane])
+                {
+                    const vector3<T> center{ local_center[0][lane], local_center[1][lane], local_center[2][lane] };
+                    touching += detail::sphere_box_contact(center, radius[lane], b, manifolds[idx]) ? 1 : 0;
+                }
+            }
+        }
+        return touching;
+    }
+
+    //a unit vector perpendicular to the unit vector normal, always the same one for the same normal
+    template <typename T>
+    vector3<T> any_tangent(vector3<T> const& normal)
+    {
+        //crossing with the axis the normal is least along keeps well clear of parallel
+        const vector3<T> magnitude = glm::abs(normal);
+        const vector3<T> axis = magnitude.x <= magnitude.y && magnitude.x <= magnitude.z ? vector3<T>{ T(1), T(0), T(0) }
+            : magnitude.y <= magnitude.z ? vector3<T>{ T(0), T(1), T(0) } : vector3<T>{ T(0), T(0), T(1) };
+        return normalize(cross(normal, axis));
+    }
+
+    //Copies the accumulated impulses of previous onto the points of current that continue them, returns how many matched.
+    //Points match by feature id, or failing that by the nearest unclaimed point within match_distance. Nothing carries over
+    //when the normal has turned far, otherwise the tangent basis is tipped onto the new normal so the tangent impulses keep
+    //pointing the way they were accumulated.
+    template <typename T>
+    u32 warm_start(contact_manifold3<T> const& previous, contact_manifold3<T>& current, T match_distance)
+    {
+        constexpr T MinNormalAlignment = T(0.95);
+
+        if (dot(previous.normal, current.normal) < MinNormalAlignment)
+        {
+            return 0;
+        }
+
+        bool claimed[contact_manifold3<T>::MaxPoints] = {};
+        u32 matched = 0;
+        for (u32 idx = 0; idx < current.point_count; ++idx)
+        {
+            contact_point3<T>& point = current.points[idx];
+
+            u32 match = previous.point_count;
+            for (u32 prev = 0; prev < previous.point_count; ++prev)
+            {
+                if (!claimed[prev] && previous.points[prev].feature == point.feature)
+                {
+                    match = prev;
+                    break;
+                }
+            }
+
+            if (match == previous.point_count)
+            {
+                T best_distance_squared = match_distance * match_distance;
+                for (u32 prev = 0; prev < previous.point_count; ++prev)
+                {
+                    const vector3<T> offset = previous.points[prev].position - point.position;
+                    if (!claimed[prev] && dot(offset, offset) <= best_distance_squared)
+                    {
+                        best_distance_squared = dot(offset, offset);
+                        match = prev;
+                    }
+                }
+            }
+
+            if (match != previous.point_count)
+            {
+                claimed[match] = true;
+                point.normal_impulse = previous.points[match].normal_impulse;
+                point.tangent_impulse = previous.points[match].tangent_impulse;
+                point.rolling_impulse = previous.points[match].rolling_impulse;
+                const vector3<T> tangent = previous.points[match].tangent - dot(previous.points[match].tangent, current.normal) * current.normal;
+                point.tangent = dot(tangent, tangent) > T(0.5) ? normalize(tangent) : vector3<T>{};
+                ++matched;
+            }
+        }
+        return matched;
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "MathTypes.h"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace jm::math
+{
+	//Union-find over elements 0 to size - 1 that several threads may unite in at once, with lock free linking and path halving.
+	//A root is always the smallest element of its set, so neither the sets nor their roots depend on the order of the unions.
+	class disjoint_set
+	{
+	public:
+		//every element back in a set of its own
+		void reset(u32 count)
+		{
+			if (count > capacity)
+			{
+				parents = std::make_unique<std::atomic<u32>[]>(count);
+				capacity = count;
+			}
+
+			element_count = count;
+			for (u32 element = 0; element < count; ++element)
+			{
+				parents[element].store(element, std::memory_order_relaxed);
+			}
+		}
+
+		u32 find(u32 element)
+		{
+			JM_MATH_ASSERT(element < element_count);
+			while (true)
+			{
+				u32 parent = parents[element].load(std::memory_order_relaxed);
+				if (parent == element)
+				{
+					return element;
+				}
+
+				//parents only ever move to smaller elements, so pointing at the grandparent is safe even if it just changed
+				const u32 grandparent = parents[parent].load(std::memory_order_relaxed);
+				if (grandparent != parent)
+				{
+					parents[element].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+				}
+				element = grandparent;
+			}
+		}
+
+		void unite(u32 first, u32 second)
+		{
+			while (true)
+			{
+				first = find(first);
+				second = find(second);
+				if (first == second)
+				{
+					return;
+				}
+
+				//hang the larger root under the smaller, retrying if another thread hung something on it meanwhile
+				if (first < second)
+				{
+					std::swap(first, second);
+				}
+
+				u32 expected = first;
+				if (parents[first].compare_exchange_strong(expected, second, std::memory_order_relaxed))
+				{
+					return;
+				}
+			}
+		}
+
+		u32 size() const { return element_count; }
+
+	private:
+		std::unique_ptr<std::atomic<u32>[]> parents;
+		u32 element_count = 0;
+		u32 capacity = 0;
+	};
+}
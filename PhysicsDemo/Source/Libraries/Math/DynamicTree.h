@@ -0,0 +1,341 @@
+#pragma once
+
+#include "Geometry.h"
+
+#include <array>
+
+namespace jm::math
+{
+	//Bounding volume hierarchy over fat (margin inflated) boxes. A leaf is only reinserted once its tight box
+	//escapes the fat box, insertion picks the sibling by surface area cost, and AVL style rotations keep it balanced.
+	template <typename T>
+	class dynamic_aabb_tree
+	{
+	public:
+		static constexpr i32 null_node = -1;
+
+		explicit dynamic_aabb_tree(T margin)
+			: margin(margin)
+		{
+		}
+
+		i32 create_proxy(aabb3<T> const& bounds, u32 user_data)
+		{
+			const i32 proxy = allocate_node();
+			nodes[proxy].bounds = inflate(bounds, margin);
+			nodes[proxy].user_data = user_data;
+			nodes[proxy].height = 0;
+			insert_leaf(proxy);
+			++proxy_count;
+			return proxy;
+		}
+
+		void destroy_proxy(i32 proxy)
+		{
+			JM_MATH_ASSERT(nodes[proxy].is_leaf());
+			remove_leaf(proxy);
+			free_node(proxy);
+			--proxy_count;
+		}
+
+		//returns true when the proxy left its fat box and had to be reinserted
+		bool move_proxy(i32 proxy, aabb3<T> const& bounds)
+		{
+			JM_MATH_ASSERT(nodes[proxy].is_leaf());
+			if (contains(nodes[proxy].bounds, bounds))
+			{
+				return false;
+			}
+
+			remove_leaf(proxy);
+			nodes[proxy].bounds = inflate(bounds, margin);
+			insert_leaf(proxy);
+			return true;
+		}
+
+		aabb3<T> const& get_fat_bounds(i32 proxy) const { return nodes[proxy].bounds; }
+		u32 get_user_data(i32 proxy) const { return nodes[proxy].user_data; }
+		uSize get_proxy_count() const { return proxy_count; }
+		i32 get_height() const { return root == null_node ? 0 : nodes[root].height; }
+		T get_margin() const { return margin; }
+
+		//calls callback(proxy) for every fat box overlapping bounds, stops early if it returns false
+		template <typename Fxn>
+		void query(aabb3<T> const& bounds, Fxn&& callback) const
+		{
+			if (root == null_node)
+			{
+				return;
+			}
+
+			traversal_stack stack;
+			stack.push(root);
+			while (!stack.empty())
+			{
+				const i32 index = stack.pop();
+				node const& current = nodes[index];
+
+				if (!intersect(current.bounds, bounds))
+				{
+					continue;
+				}
+
+				if (current.is_leaf())
+				{
+					if (!callback(index))
+					{
+						return;
+					}
+				}
+				else
+				{
+					stack.push(current.child1);
+					stack.push(current.child2);
+				}
+			}
+		}
+
+		//calls callback(proxy, max_t) for every fat box the ray enters before max_t. The callback returns the new
+		//max_t: the same value to keep going, a hit distance to clip the ray, or zero to stop.
+		template <typename Fxn>
+		void ray_cast(ray3<T> const& ray, T max_t, Fxn&& callback) const
+		{
+			if (root == null_node)
+			{
+				return;
+			}
+
+			traversal_stack stack;
+			stack.push(root);
+			while (!stack.empty() && max_t > T(0))
+			{
+				const i32 index = stack.pop();
+				node const& current = nodes[index];
+
+				T hit_t{};
+				if (!intersect(ray, current.bounds, max_t, hit_t))
+				{
+					continue;
+				}
+
+				if (current.is_leaf())
+				{
+					max_t = callback(index, max_t);
+				}
+				else
+				{
+					stack.push(current.child1);
+					stack.push(current.child2);
+				}
+			}
+		}
+
+	private:
+		//depth first traversal never holds more than height + 1 nodes, far below this for a balanced tree
+		struct traversal_stack
+		{
+			std::array<i32, 256> items;
+			uSize size = 0;
+
+			void push(i32 index)
+			{
+				JM_MATH_ASSERT(size < items.size());
+				items[size++] = index;
+			}
+
+			i32 pop() { return items[--size]; }
+			bool empty() const { return size == 0; }
+		};
+
+		struct node
+		{
+			aabb3<T> bounds;
+			i32 parent = null_node;
+			i32 child1 = null_node;
+			i32 child2 = null_node;
+			i32 next = null_node; //free list link
+			i32 height = -1; //leaves are 0, free nodes -1
+			u32 user_data = 0;
+
+			bool is_leaf() const { return child1 == null_node; }
+		};
+
+		i32 allocate_node()
+		{
+			if (free_list == null_node)
+			{
+				nodes.emplace_back();
+				return static_cast<i32>(nodes.size() - 1);
+			}
+
+			const i32 index = free_list;
+			free_list = nodes[index].next;
+			nodes[index] = node{};
+			return index;
+		}
+
+		void free_node(i32 index)
+		{
+			nodes[index].next = free_list;
+			nodes[index].height = -1;
+			free_list = index;
+		}
+
+		void refit(i32 index)
+		{
+			node& current = nodes[index];
+			current.bounds = merge(nodes[current.child1].bounds, nodes[current.child2].bounds);
+			current.height = 1 + std::max(nodes[current.child1].height, nodes[current.child2].height);
+		}
+
+		void replace_child(i32 parent, i32 old_child, i32 new_child)
+		{
+			if (parent == null_node)
+			{
+				root = new_child;
+			}
+			else if (nodes[parent].child1 == old_child)
+			{
+				nodes[parent].child1 = new_child;
+			}
+			else
+			{
+				nodes[parent].child2 = new_child;
+			}
+		}
+
+		void refit_ancestors(i32 index)
+		{
+			while (index != null_node)
+			{
+				index = balance(index);
+				refit(index);
+				index = nodes[index].parent;
+			}
+		}
+
+		void insert_leaf(i32 leaf)
+		{
+			if (root == null_node)
+			{
+				root = leaf;
+				nodes[leaf].parent = null_node;
+				return;
+			}
+
+			//descend while it is cheaper to push the leaf further down than to pair it here
+			const aabb3<T> leaf_bounds = nodes[leaf].bounds;
+			i32 index = root;
+			while (!nodes[index].is_leaf())
+			{
+				node const& current = nodes[index];
+				const T area = surface_area(current.bounds);
+				const T combined_area = surface_area(merge(current.bounds, leaf_bounds));
+
+				const T cost = T(2) * combined_area;
+				const T inheritance_cost = T(2) * (combined_area - area);
+
+				auto child_cost = [&](i32 child)
+				{
+					const T merged_area = surface_area(merge(leaf_bounds, nodes[child].bounds));
+					return (nodes[child].is_leaf() ? merged_area : merged_area - surface_area(nodes[child].bounds)) + inheritance_cost;
+				};
+
+				const T cost1 = child_cost(current.child1);
+				const T cost2 = child_cost(current.child2);
+				if (cost < cost1 && cost < cost2)
+				{
+					break;
+				}
+				index = cost1 < cost2 ? current.child1 : current.child2;
+			}
+
+			const i32 sibling = index;
+			const i32 old_parent = nodes[sibling].parent;
+			const i32 new_parent = allocate_node();
+			nodes[new_parent].parent = old_parent;
+			nodes[new_parent].child1 = sibling;
+			nodes[new_parent].child2 = leaf;
+			nodes[sibling].parent = new_parent;
+			nodes[leaf].parent = new_parent;
+			replace_child(old_parent, sibling, new_parent);
+
+			refit_ancestors(new_parent);
+		}
+
+		void remove_leaf(i32 leaf)
+		{
+			if (leaf == root)
+			{
+				root = null_node;
+				return;
+			}
+
+			const i32 parent = nodes[leaf].parent;
+			const i32 grand_parent = nodes[parent].parent;
+			const i32 sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+			replace_child(grand_parent, parent, sibling);
+			nodes[sibling].parent = grand_parent;
+			free_node(parent);
+
+			refit_ancestors(grand_parent);
+		}
+
+		//rotates the taller grandchild up when the children of a differ in height by more than one
+		i32 balance(i32 a)
+		{
+			if (nodes[a].is_leaf() || nodes[a].height < 2)
+			{
+				return a;
+			}
+
+			const i32 b = nodes[a].child1;
+			const i32 c = nodes[a].child2;
+			const i32 difference = nodes[c].height - nodes[b].height;
+
+			if (difference > 1)
+			{
+				return rotate_up(a, c, b, true);
+			}
+			if (difference < -1)
+			{
+				return rotate_up(a, b, c, false);
+			}
+			return a;
+		}
+
+		//promotes child to replace a, a keeps other and the shorter grandchild of child
+		i32 rotate_up(i32 a, i32 child, i32 other, bool child_is_second)
+		{
+			const i32 f = nodes[child].child1;
+			const i32 g = nodes[child].child2;
+
+			nodes[child].child1 = a;
+			nodes[child].parent = nodes[a].parent;
+			nodes[a].parent = child;
+			replace_child(nodes[child].parent, a, child);
+
+			const bool f_taller = nodes[f].height > nodes[g].height;
+			const i32 kept = f_taller ? f : g;
+			const i32 moved = f_taller ? g : f;
+
+			nodes[child].child2 = kept;
+			(child_is_second ? nodes[a].child2 : nodes[a].child1) = moved;
+			nodes[moved].parent = a;
+
+			nodes[a].bounds = merge(nodes[other].bounds, nodes[moved].bounds);
+			nodes[a].height = 1 + std::max(nodes[other].height, nodes[moved].height);
+			nodes[child].bounds = merge(nodes[a].bounds, nodes[kept].bounds);
+			nodes[child].height = 1 + std::max(nodes[a].height, nodes[kept].height);
+
+			return child;
+		}
+
+		std::vector<node> nodes;
+		i32 root = null_node;
+		i32 free_list = null_node;
+		uSize proxy_count = 0;
+		T margin;
+	};
+}
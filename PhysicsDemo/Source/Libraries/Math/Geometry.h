@@ -2,6 +2,8 @@
 
 #include "MathTypes.h"
 
+#include <algorithm>
+
 namespace jm::math
 {
     template <typename T>
@@ -19,11 +21,87 @@ namespace jm::math
         math::matrix33<T> axes{}; //orthonormal
     };
 
+    template <typename T>
+    struct aabb3
+    {
+        vector3<T> min{};
+        vector3<T> max{};
+    };
+
+    template <typename T>
+    struct ray3
+    {
+        vector3<T> origin{};
+        vector3<T> direction{}; //not required to be normalized, distances are in multiples of it
+    };
+
+    template <typename T>
+    aabb3<T> bounding_box(sphere3<T> const& a)
+    {
+        return { a.center - vector3<T>(a.radius), a.center + vector3<T>(a.radius) };
+    };
+
+    template <typename T>
+    aabb3<T> bounding_box(box3<T> const& a)
+    {
+        //project each rotated half axis onto the world axes
+        const vector3<T> half_size = glm::abs(a.axes[0]) * a.extents.x + glm::abs(a.axes[1]) * a.extents.y + glm::abs(a.axes[2]) * a.extents.z;
+        return { a.position - half_size, a.position + half_size };
+    };
+
+    template <typename T>
+    vector3<T> center(aabb3<T> const& a)
+    {
+        return (a.min + a.max) * T(0.5);
+    };
+
+    template <typename T>
+    vector3<T> size(aabb3<T> const& a)
+    {
+        return a.max - a.min;
+    };
+
+    template <typename T>
+    T surface_area(aabb3<T> const& a)
+    {
+        const vector3<T> d = a.max - a.min;
+        return T(2) * (d.x * d.y + d.y * d.z + d.z * d.x);
+    };
+
+    template <typename T>
+    aabb3<T> merge(aabb3<T> const& a, aabb3<T> const& b)
+    {
+        return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+    };
+
+    template <typename T>
+    aabb3<T> inflate(aabb3<T> const& a, T margin)
+    {
+        return { a.min - vector3<T>(margin), a.max + vector3<T>(margin) };
+    };
+
+    template <typename T>
+    bool contains(aabb3<T> const& outer, aabb3<T> const& inner)
+    {
+        return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+            inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+    };
+
+    template <typename T>
+    bool intersect(aabb3<T> const& a, aabb3<T> const& b)
+    {
+        return a.min.x <= b.max.x && b.min.x <= a.max.x &&
+            a.min.y <= b.max.y && b.min.y <= a.max.y &&
+            a.min.z <= b.max.z && b.min.z <= a.max.z;
+    };
+
     template <typename T>
     bool intersect(sphere3<T> const& a, sphere3<T> const& b)
     {
+        //compare squared distance against the squared radius sum, not the radius sum itself
         const vector3<T> center_displacement = a.center - b.center;
-        return dot(center_displacement, center_displacement) < a.radius + b.radius + math::epsilon<T>();
+        const T radius_sum = a.radius + b.radius;
+        return dot(center_displacement, center_displacement) <= radius_sum * radius_sum;
     };
 
     template <typename T>
@@ -39,15 +117,81 @@ namespace jm::math
     };
 
 
+    //point of the box nearest to a, a itself when it is inside
+    template <typename T>
+    vector3<T> closest_point(vector3<T> const& a, box3<T> const& b)
+    {
+        const vector3<T> box_local_point = glm::transpose(b.axes) * (a - b.position);
+        return b.position + b.axes * glm::clamp(box_local_point, -b.extents, b.extents);
+    };
+
     template <typename T>
     bool intersect(sphere3<T> const& a, box3<T> const& b)
     {
-        vector3<T> box_local_point = a.center - b.position;
-        box_local_point = glm::transpose(b.axes) * box_local_point;
+        //against the closest point rather than the box grown by the radius, which also accepts spheres just off edges and corners
+        const vector3<T> offset = a.center - closest_point(a.center, b);
+        return dot(offset, offset) <= a.radius * a.radius;
+    };
+
+    //farthest point of the shape along direction, which does not need to be normalized
+    template <typename T>
+    vector3<T> support(vector3<T> const& a, vector3<T> const&)
+    {
+        return a;
+    };
+
+    template <typename T>
+    vector3<T> support(sphere3<T> const& a, vector3<T> const& direction)
+    {
+        const T length_squared = dot(direction, direction);
+        return length_squared > math::epsilon<T>() ? a.center + direction * (a.radius / std::sqrt(length_squared)) : a.center;
+    };
+
+    template <typename T>
+    vector3<T> support(box3<T> const& a, vector3<T> const& direction)
+    {
+        vector3<T> result = a.position;
+        for (glm::length_t axis = 0; axis < 3; ++axis)
+        {
+            result += (dot(direction, a.axes[axis]) < T(0) ? -a.extents[axis] : a.extents[axis]) * a.axes[axis];
+        }
+        return result;
+    };
+
+    //slab test, writes the entry distance along the ray when it hits within [0, max_t]
+    template <typename T>
+    bool intersect(ray3<T> const& a, aabb3<T> const& b, T max_t, T& hit_t)
+    {
+        T t_min = T(0);
+        T t_max = max_t;
+        for (glm::length_t axis = 0; axis < 3; ++axis)
+        {
+            if (std::abs(a.direction[axis]) < math::epsilon<T>())
+            {
+                if (a.origin[axis] < b.min[axis] || b.max[axis] < a.origin[axis])
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            const T inverse_direction = T(1) / a.direction[axis];
+            T t_near = (b.min[axis] - a.origin[axis]) * inverse_direction;
+            T t_far = (b.max[axis] - a.origin[axis]) * inverse_direction;
+            if (t_near > t_far)
+            {
+                std::swap(t_near, t_far);
+            }
 
-        return std::abs(box_local_point.x) < b.extents.x + a.radius + math::epsilon<T>() &&
-            std::abs(box_local_point.y) < b.extents.y + a.radius + math::epsilon<T>() &&
-            std::abs(box_local_point.z) < b.extents.z + a.radius + math::epsilon<T>();
+            t_min = std::max(t_min, t_near);
+            t_max = std::min(t_max, t_far);
+            if (t_min > t_max)
+            {
+                return false;
+            }
+        }
 
+        hit_t = t_min;
+        return true;
     };
-}
+}
\ No newline at end of file
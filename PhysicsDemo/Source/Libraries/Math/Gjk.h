@@ -0,0 +1,579 @@
+#pragma once
+
+#include "Contact.h"
+
+#include <initializer_list>
+#include <utility>
+
+namespace jm::math
+{
+    //search directions of the last simplex for a pair, replayed on the next query so coherent pairs start next to the answer
+    template <typename T>
+    struct gjk_cache
+    {
+        std::array<vector3<T>, 4> directions{};
+        u32 count = 0;
+    };
+
+    template <typename T>
+    struct gjk_output
+    {
+        T distance{}; //zero when the shapes overlap
+        vector3<T> point_a{}; //closest point on a
+        vector3<T> point_b{}; //closest point on b
+        bool overlapping = false;
+        u32 iterations = 0;
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        struct simplex_vertex
+        {
+            vector3<T> a; //support point on a
+            vector3<T> b; //support point on b
+            vector3<T> w; //a - b, a point of the Minkowski difference
+            vector3<T> direction; //direction that produced it
+        };
+
+        template <typename T>
+        struct simplex
+        {
+            std::array<simplex_vertex<T>, 4> vertices;
+            std::array<T, 4> weights; //barycentric weights of the point closest to the origin
+            u32 count = 0;
+        };
+
+        template <typename T, typename ShapeA, typename ShapeB>
+        simplex_vertex<T> minkowski_support(ShapeA const& a, ShapeB const& b, vector3<T> const& direction)
+        {
+            const vector3<T> point_a = support(a, direction);
+            const vector3<T> point_b = support(b, -direction);
+            return { point_a, point_b, point_a - point_b, direction };
+        }
+
+        template <typename T>
+        vector3<T> closest_point(simplex<T> const& s)
+        {
+            vector3<T> result{ T(0) };
+            for (u32 idx = 0; idx < s.count; ++idx)
+            {
+                result += s.weights[idx] * s.vertices[idx].w;
+            }
+            return result;
+        }
+
+        template <typename T>
+        void reduce(simplex<T>& s, std::initializer_list<std::pair<u32, T>> kept)
+        {
+            std::array<simplex_vertex<T>, 4> vertices = s.vertices;
+            s.count = 0;
+            for (auto [index, weight] : kept)
+            {
+                s.vertices[s.count] = vertices[index];
+                s.weights[s.count++] = weight;
+            }
+        }
+
+        template <typename T>
+        void solve_segment(simplex<T>& s, u32 i0, u32 i1)
+        {
+            const vector3<T> a = s.vertices[i0].w;
+            const vector3<T> ab = s.vertices[i1].w - a;
+            const T length_squared = dot(ab, ab);
+            const T t = length_squared > T(0) ? -dot(a, ab) / length_squared : T(0);
+            if (t <= T(0))
+            {
+                reduce(s, { { i0, T(1) } });
+            }
+            else if (t >= T(1))
+            {
+                reduce(s, { { i1, T(1) } });
+            }
+            else
+            {
+                reduce(s, { { i0, T(1) - t }, { i1, t } });
+            }
+        }
+
+        //closest point to the origin by Voronoi regions, Ericson's Real-Time Collision Detection 5.1.5
+        template <typename T>
+        void solve_triangle(simplex<T>& s, u32 i0, u32 i1, u32 i2)
+        {
+            const vector3<T> a = s.vertices[i0].w;
+            const vector3<T> b = s.vertices[i1].w;
+            const vector3<T> c = s.vertices[i2].w;
+            const vector3<T> ab = b - a;
+            const vector3<T> ac = c - a;
+
+            const T d1 = -dot(ab, a);
+            const T d2 = -dot(ac, a);
+            if (d1 <= T(0) && d2 <= T(0))
+            {
+                return reduce(s, { { i0, T(1) } });
+            }
+
+            const T d3 = -dot(ab, b);
+            const T d4 = -dot(ac, b);
+            if (d3 >= T(0) && d4 <= d3)
+            {
+                return reduce(s, { { i1, T(1) } });
+            }
+
+            const T vc = d1 * d4 - d3 * d2;
+            if (vc <= T(0) && d1 >= T(0) && d3 <= T(0))
+            {
+                const T v = d1 / (d1 - d3);
+                return reduce(s, { { i0, T(1) - v }, { i1, v } });
+            }
+
+            const T d5 = -dot(ab, c);
+            const T d6 = -dot(ac, c);
+            if (d6 >= T(0) && d5 <= d6)
+            {
+                return reduce(s, { { i2, T(1) } });
+            }
+
+            const T vb = d5 * d2 - d1 * d6;
+            if (vb <= T(0) && d2 >= T(0) && d6 <= T(0))
+            {
+                const T w = d2 / (d2 - d6);
+                return reduce(s, { { i0, T(1) - w }, { i2, w } });
+            }
+
+            const T va = d3 * d6 - d5 * d4;
+            if (va <= T(0) && (d4 - d3) >= T(0) && (d5 - d6) >= T(0))
+            {
+                const T w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+                return reduce(s, { { i1, T(1) - w }, { i2, w } });
+            }
+
+            const T area = va + vb + vc;
+            if (area <= T(0))
+            {
+                //degenerate triangle, every region test failed only through rounding
+                return solve_segment(s, i0, i1);
+            }
+
+            const T v = vb / area;
+            const T w = vc / area;
+            reduce(s, { { i0, T(1) - v - w }, { i1, v }, { i2, w } });
+        }
+
+        //returns false when the origin is inside the tetrahedron, otherwise reduces to the closest face feature
+        template <typename T>
+        bool solve_tetrahedron(simplex<T>& s)
+        {
+            constexpr std::array<std::array<u32, 4>, 4> Faces = { { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } } };
+
+            constexpr T FlatTolerance = T(1e-3); //sine of the angle the last vertex makes with the opposite face
+
+            //a flat tetrahedron has no inside to trust, so every face counts as facing the origin
+            const vector3<T> e0 = s.vertices[1].w - s.vertices[0].w;
+            const vector3<T> e1 = s.vertices[2].w - s.vertices[0].w;
+            const vector3<T> e2 = s.vertices[3].w - s.vertices[0].w;
+            const T volume = std::abs(dot(cross(e0, e1), e2));
+            const bool flat = volume <= FlatTolerance * length(cross(e0, e1)) * length(e2);
+
+            simplex<T> best;
+            T best_distance = infinity<T>();
+            bool outside_any = false;
+            for (auto const& face : Faces)
+            {
+                const vector3<T> a = s.vertices[face[0]].w;
+                const vector3<T> normal = cross(s.vertices[face[1]].w - a, s.vertices[face[2]].w - a);
+                const T origin_side = -dot(normal, a);
+                const T opposite_side = dot(normal, s.vertices[face[3]].w - a);
+
+                if (flat || origin_side * opposite_side < T(0))
+                {
+                    outside_any = true;
+                    simplex<T> candidate = s;
+                    solve_triangle(candidate, face[0], face[1], face[2]);
+                    const vector3<T> point = closest_point(candidate);
+                    if (dot(point, point) < best_distance)
+                    {
+                        best_distance = dot(point, point);
+                        best = candidate;
+                    }
+                }
+            }
+
+            if (outside_any)
+            {
+                s = best;
+            }
+            return outside_any;
+        }
+
+        template <typename T>
+        bool solve(simplex<T>& s)
+        {
+            switch (s.count)
+            {
+            case 1:
+                s.weights[0] = T(1);
+                return true;
+            case 2:
+                solve_segment(s, 0, 1);
+                return true;
+            case 3:
+                solve_triangle(s, 0, 1, 2);
+                return true;
+            default:
+                return solve_tetrahedron(s);
+            }
+        }
+
+        template <typename T>
+        bool contains_point(simplex<T> const& s, vector3<T> const& w)
+        {
+            for (u32 idx = 0; idx < s.count; ++idx)
+            {
+                const vector3<T> offset = s.vertices[idx].w - w;
+                if (dot(offset, offset) <= epsilon<T>() * std::max(T(1), dot(w, w)))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //distance between two convex shapes given only their support functions, leaves the final simplex in s
+        template <typename T, typename ShapeA, typename ShapeB>
+        gjk_output<T> gjk(ShapeA const& a, ShapeB const& b, gjk_cache<T>& cache, simplex<T>& s)
+        {
+            constexpr u32 MaxIterations = 32;
+            constexpr T RelativeTolerance = T(1e-4);
+            constexpr T OverlapTolerance = T(1e-6);
+
+            s.count = 0;
+            for (u32 idx = 0; idx < cache.count; ++idx)
+            {
+                const simplex_vertex<T> vertex = minkowski_support(a, b, cache.directions[idx]);
+                if (!contains_point(s, vertex.w))
+                {
+                    s.vertices[s.count++] = vertex;
+                }
+            }
+            if (s.count == 0)
+            {
+                s.vertices[s.count++] = minkowski_support(a, b, vector3<T>(T(1), T(0), T(0)));
+            }
+
+            gjk_output<T> output;
+            simplex<T> previous = s;
+            T previous_distance_squared = infinity<T>();
+            while (true)
+            {
+                ++output.iterations;
+                if (!solve(s))
+                {
+                    output.overlapping = true;
+                    break;
+                }
+
+                const vector3<T> closest = closest_point(s);
+                const T distance_squared = dot(closest, closest);
+                if (distance_squared <= OverlapTolerance * OverlapTolerance)
+                {
+                    output.overlapping = true;
+                    break;
+                }
+
+                //a nearly flat simplex can solve to a worse point through rounding, keep the last good one
+                if (distance_squared >= previous_distance_squared)
+                {
+                    s = previous;
+                    break;
+                }
+                if (output.iterations == MaxIterations)
+                {
+                    break;
+                }
+
+                //stop once the next support point cannot bring the closest point meaningfully nearer the origin
+                const simplex_vertex<T> vertex = minkowski_support(a, b, -closest);
+                if (distance_squared - dot(closest, vertex.w) <= RelativeTolerance * distance_squared || contains_point(s, vertex.w))
+                {
+                    break;
+                }
+
+                previous = s;
+                previous_distance_squared = distance_squared;
+                s.vertices[s.count++] = vertex;
+            }
+
+            cache.count = s.count;
+            for (u32 idx = 0; idx < s.count; ++idx)
+            {
+                cache.directions[idx] = s.vertices[idx].direction;
+                output.point_a += s.weights[idx] * s.vertices[idx].a;
+                output.point_b += s.weights[idx] * s.vertices[idx].b;
+            }
+            output.distance = output.overlapping ? T(0) : length(output.point_b - output.point_a);
+            return output;
+        }
+
+        //grows a simplex that touches the origin into a tetrahedron with volume, false if the difference is flat
+        template <typename T, typename ShapeA, typename ShapeB>
+        bool expand_to_tetrahedron(ShapeA const& a, ShapeB const& b, simplex<T>& s)
+        {
+            auto try_add = [&](vector3<T> const& direction)
+            {
+                for (T sign : { T(1), T(-1) })
+                {
+                    const simplex_vertex<T> vertex = minkowski_support(a, b, sign * direction);
+                    bool independent = !contains_point(s, vertex.w);
+                    if (independent && s.count >= 2)
+                    {
+                        const vector3<T> offset = cross(s.vertices[1].w - s.vertices[0].w, vertex.w - s.vertices[0].w);
+                        independent = s.count == 2 ? dot(offset, offset) > epsilon<T>() : std::abs(dot(offset, s.vertices[2].w - s.vertices[0].w)) > epsilon<T>();
+                    }
+                    if (independent)
+                    {
+                        s.vertices[s.count++] = vertex;
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            const std::array<vector3<T>, 3> axes = { vector3<T>(T(1), T(0), T(0)), vector3<T>(T(0), T(1), T(0)), vector3<T>(T(0), T(0), T(1)) };
+            if (s.count == 1)
+            {
+                for (vector3<T> const& axis : axes)
+                {
+                    if (try_add(axis))
+                    {
+                        break;
+                    }
+                }
+            }
+            if (s.count == 2)
+            {
+                //sweep directions around the segment
+                const vector3<T> direction = s.vertices[1].w - s.vertices[0].w;
+                const vector3<T> least_aligned = std::abs(direction.x) < std::abs(direction.y) ? (std::abs(direction.x) < std::abs(direction.z) ? axes[0] : axes[2]) : (std::abs(direction.y) < std::abs(direction.z) ? axes[1] : axes[2]);
+                const vector3<T> u = cross(direction, least_aligned);
+                const vector3<T> v = cross(direction, u);
+                for (T angle : { T(0), pi<T>() / T(3), T(2) * pi<T>() / T(3) })
+                {
+                    if (try_add(std::cos(angle) * u + std::sin(angle) * v))
+                    {
+                        break;
+                    }
+                }
+            }
+            if (s.count == 3)
+            {
+                try_add(cross(s.vertices[1].w - s.vertices[0].w, s.vertices[2].w - s.vertices[0].w));
+            }
+            return s.count == 4;
+        }
+
+        //Expanding polytope algorithm. Grows the simplex around the origin towards the nearest face of the Minkowski
+        //difference, whose normal and distance give the minimum translation that separates the shapes.
+        template <typename T, typename ShapeA, typename ShapeB>
+        bool epa(ShapeA const& a, ShapeB const& b, simplex<T> s, vector3<T>& normal, T& depth, vector3<T>& point_a, vector3<T>& point_b)
+        {
+            constexpr u32 MaxVertices = 64;
+            constexpr u32 MaxFaces = 2 * MaxVertices;
+            constexpr u32 MaxIterations = MaxVertices - 4;
+            constexpr T RelativeTolerance = T(1e-4);
+
+            if (!expand_to_tetrahedron(a, b, s))
+            {
+                return false;
+            }
+
+            struct face
+            {
+                std::array<u32, 3> vertices;
+                vector3<T> normal;
+                T distance;
+                bool valid;
+            };
+
+            std::array<simplex_vertex<T>, MaxVertices> vertices;
+            std::array<face, MaxFaces> faces;
+            u32 vertex_count = 4;
+            u32 face_count = 0;
+            std::copy_n(s.vertices.begin(), 4, vertices.begin());
+
+            auto add_face = [&](u32 i0, u32 i1, u32 i2)
+            {
+                const vector3<T> p0 = vertices[i0].w;
+                const vector3<T> n = cross(vertices[i1].w - p0, vertices[i2].w - p0);
+                const T n_length = length(n);
+                face& added = faces[face_count++];
+                added.vertices = { i0, i1, i2 };
+                added.valid = true;
+                if (n_length > epsilon<T>())
+                {
+                    added.normal = n / n_length;
+                    added.distance = dot(added.normal, p0);
+                }
+                else
+                {
+                    //keeps the hull closed but is never chosen as the nearest face
+                    added.normal = vector3<T>(T(0));
+                    added.distance = infinity<T>();
+                }
+            };
+
+            //wind the tetrahedron faces outwards
+            const bool flipped = dot(cross(vertices[1].w - vertices[0].w, vertices[2].w - vertices[0].w), vertices[3].w - vertices[0].w) > T(0);
+            const std::array<std::array<u32, 3>, 4> tetrahedron = { { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } } };
+            for (auto const& f : tetrahedron)
+            {
+                flipped ? add_face(f[0], f[2], f[1]) : add_face(f[0], f[1], f[2]);
+            }
+
+            auto find_nearest = [&]()
+            {
+                face const* result = nullptr;
+                for (u32 idx = 0; idx < face_count; ++idx)
+                {
+                    if (faces[idx].valid && (result == nullptr || faces[idx].distance < result->distance))
+                    {
+                        result = &faces[idx];
+                    }
+                }
+                return result;
+            };
+
+            std::array<std::array<u32, 2>, MaxFaces> horizon;
+            face const* nearest = find_nearest();
+            for (u32 iteration = 0; iteration < MaxIterations && nearest != nullptr && nearest->distance != infinity<T>(); ++iteration)
+            {
+                const simplex_vertex<T> vertex = minkowski_support(a, b, nearest->normal);
+                const T support_distance = dot(vertex.w, nearest->normal);
+                if (support_distance - nearest->distance <= RelativeTolerance * std::max(T(1), nearest->distance) || vertex_count == MaxVertices)
+                {
+                    break;
+                }
+
+                //remove every face the new point sees, the edges used only once among them form the horizon
+                u32 horizon_count = 0;
+                for (u32 idx = 0; idx < face_count; ++idx)
+                {
+                    face& current = faces[idx];
+                    if (!current.valid || dot(current.normal, vertex.w - vertices[current.vertices[0]].w) <= T(0))
+                    {
+                        continue;
+                    }
+
+                    current.valid = false;
+                    for (u32 edge = 0; edge < 3; ++edge)
+                    {
+                        const std::array<u32, 2> e = { current.vertices[edge], current.vertices[(edge + 1) % 3] };
+                        auto shared = std::find(horizon.begin(), horizon.begin() + horizon_count, std::array<u32, 2>{ e[1], e[0] });
+                        if (shared != horizon.begin() + horizon_count)
+                        {
+                            *shared = horizon[--horizon_count];
+                        }
+                        else
+                        {
+                            horizon[horizon_count++] = e;
+                        }
+                    }
+                }
+
+                //compact out the removed faces before adding the new fan
+                face_count = static_cast<u32>(std::remove_if(faces.begin(), faces.begin() + face_count, [](face const& f) { return !f.valid; }) - faces.begin());
+                if (face_count + horizon_count > MaxFaces)
+                {
+                    return false;
+                }
+
+                vertices[vertex_count] = vertex;
+                for (u32 idx = 0; idx < horizon_count; ++idx)
+                {
+                    add_face(horizon[idx][0], horizon[idx][1], vertex_count);
+                }
+                ++vertex_count;
+                nearest = find_nearest();
+            }
+
+            if (nearest == nullptr || nearest->distance == infinity<T>())
+            {
+                return false;
+            }
+
+            //barycentric weights of the origin projected onto the nearest face give the witness points
+            simplex_vertex<T> const& v0 = vertices[nearest->vertices[0]];
+            simplex_vertex<T> const& v1 = vertices[nearest->vertices[1]];
+            simplex_vertex<T> const& v2 = vertices[nearest->vertices[2]];
+            const vector3<T> projected = nearest->distance * nearest->normal;
+            const vector3<T> e0 = v1.w - v0.w;
+            const vector3<T> e1 = v2.w - v0.w;
+            const vector3<T> e2 = projected - v0.w;
+            const T d00 = dot(e0, e0);
+            const T d01 = dot(e0, e1);
+            const T d11 = dot(e1, e1);
+            const T d20 = dot(e2, e0);
+            const T d21 = dot(e2, e1);
+            const T denominator = d00 * d11 - d01 * d01;
+            const T v = denominator > T(0) ? (d11 * d20 - d01 * d21) / denominator : T(0);
+            const T w = denominator > T(0) ? (d00 * d21 - d01 * d20) / denominator : T(0);
+            const T u = T(1) - v - w;
+
+            normal = nearest->normal;
+            depth = std::max(nearest->distance, T(0));
+            point_a = u * v0.a + v * v1.a + w * v2.a;
+            point_b = u * v0.b + v * v1.b + w * v2.b;
+            return true;
+        }
+    }
+
+    //Closest points between any two convex shapes that provide support(shape, direction). The cache holds the simplex
+    //directions of the previous query for the same pair, so coherent pairs converge in one or two iterations.
+    template <typename T, typename ShapeA, typename ShapeB>
+    gjk_output<T> gjk_distance(ShapeA const& a, ShapeB const& b, gjk_cache<T>& cache)
+    {
+        detail::simplex<T> s;
+        return detail::gjk(a, b, cache, s);
+    }
+
+    //Single point contact between convex shapes, each the core shape inflated by a radius so spheres and capsules
+    //can use a point or segment core. Separated cores use the GJK closest points, overlapping cores fall back to EPA.
+    template <typename T, typename ShapeA, typename ShapeB>
+    bool collide(ShapeA const& a, ShapeB const& b, gjk_cache<T>& cache, contact_manifold3<T>& manifold, T a_radius = T(0), T b_radius = T(0))
+    {
+        manifold.point_count = 0;
+
+        detail::simplex<T> s;
+        const gjk_output<T> output = detail::gjk(a, b, cache, s);
+        const T radius = a_radius + b_radius;
+
+        vector3<T> normal;
+        vector3<T> point_a = output.point_a;
+        vector3<T> point_b = output.point_b;
+        T depth{};
+        if (!output.overlapping && output.distance > epsilon<T>())
+        {
+            if (output.distance > radius)
+            {
+                return false;
+            }
+            normal = (point_b - point_a) / output.distance;
+            depth = radius - output.distance;
+        }
+        else if (detail::epa(a, b, s, normal, depth, point_a, point_b))
+        {
+            depth += radius;
+        }
+        else
+        {
+            return false;
+        }
+
+        point_a += a_radius * normal;
+        point_b -= b_radius * normal;
+        manifold.normal = normal;
+        manifold.points[0] = { T(0.5) * (point_a + point_b), depth, 0 };
+        manifold.point_count = 1;
+        return true;
+    }
+}
@@ -42,8 +42,9 @@ namespace jm::math
 		{}
 		vector3<T> applied_force{};
 		vector3<T> velocity;
-		const T mass;
-		const T inverse_mass;
+		T mass; //not const so groups can pack bodies
+		T inverse_mass;
+		vector3<T> start_position{}; //where the body started its last step from, for solvers that take the step again
 	};
 
 	template <typename T>
@@ -67,13 +68,23 @@ namespace jm::math
 			: velocity(omega0)
 			, inertia(inertia)
 			, inverse_inertia(T(1) / inertia)
+			, world_inverse_inertia(inverse_inertia.x, T(0), T(0), T(0), inverse_inertia.y, T(0), T(0), T(0), inverse_inertia.z)
 		{}
 		vector3<T> applied_torque{};
-		vector3<T> velocity;
-		const vector3<T> inertia; //Assumes symmetric shapes
-		const vector3<T> inverse_inertia;
+		vector3<T> velocity; //world axes
+		vector3<T> inertia; //Assumes symmetric shapes, principal axes are the body's own. Not const so groups can pack bodies
+		vector3<T> inverse_inertia;
+		quaternion<T> start_orientation{ T(1), T(0), T(0), T(0) }; //like linear_body3::start_position
+		matrix33<T> world_inverse_inertia; //inverse_inertia turned into world axes at start_orientation, kept by the simulation
 	};
 
+	//a pose t of the way from a to b, turning the short way round
+	template <typename T>
+	rigid_motion3<T> interpolate(rigid_motion3<T> const& a, rigid_motion3<T> const& b, T t)
+	{
+		return { lerp(t, a.position, b.position), glm::slerp(a.orientation, b.orientation, t) };
+	}
+
 	template <typename T, typename V>
 	inline void euler_integration(V& value, V const& derivative, T delta_t)
 	{
@@ -85,4 +96,71 @@ namespace jm::math
 	{
 		value += (delta_t * (last_derivative + derivative) * 0.5f);
 	}
+
+	//Integrator policies, each advancing a position and velocity over delta_t under an acceleration of the two. The new
+	//velocity is scaled by damping as the last part of its update, so a scheme that moves with the new velocity moves with
+	//the damped one. Picked at compile time, so the step inlines into whatever loops over the bodies.
+
+	//first order, moves with the velocity the step started with and gains energy every step
+	struct explicit_euler
+	{
+		template <typename V, typename T, typename Acceleration>
+		static void step(V& position, V& velocity, Acceleration const& acceleration, T damping, T delta_t)
+		{
+			const V start_acceleration = acceleration(position, velocity);
+			euler_integration(position, velocity, delta_t);
+			euler_integration(velocity, start_acceleration, delta_t);
+			velocity *= damping;
+		}
+	};
+
+	//first order and symplectic, the velocity is updated first and then moves the position
+	struct semi_implicit_euler
+	{
+		template <typename V, typename T, typename Acceleration>
+		static void step(V& position, V& velocity, Acceleration const& acceleration, T damping, T delta_t)
+		{
+			euler_integration(velocity, acceleration(position, velocity), delta_t);
+			velocity *= damping;
+			euler_integration(position, velocity, delta_t);
+		}
+	};
+
+	//Second order and symplectic for accelerations of the position alone. The end acceleration is taken at the velocity the
+	//start acceleration predicts, which is exact for those and close for the rest.
+	struct velocity_verlet
+	{
+		template <typename V, typename T, typename Acceleration>
+		static void step(V& position, V& velocity, Acceleration const& acceleration, T damping, T delta_t)
+		{
+			const V start_acceleration = acceleration(position, velocity);
+			position += delta_t * velocity + (T(0.5) * delta_t * delta_t) * start_acceleration;
+			const V end_acceleration = acceleration(position, velocity + delta_t * start_acceleration);
+			trapezoidal_integration(velocity, end_acceleration, start_acceleration, delta_t);
+			velocity *= damping;
+		}
+	};
+
+	//fourth order Runge-Kutta over position and velocity together, four accelerations a step
+	struct runge_kutta4
+	{
+		template <typename V, typename T, typename Acceleration>
+		static void step(V& position, V& velocity, Acceleration const& acceleration, T damping, T delta_t)
+		{
+			const T half_t = T(0.5) * delta_t;
+			const V velocity1 = velocity;
+			const V acceleration1 = acceleration(position, velocity1);
+			const V velocity2 = velocity + half_t * acceleration1;
+			const V acceleration2 = acceleration(position + half_t * velocity1, velocity2);
+			const V velocity3 = velocity + half_t * acceleration2;
+			const V acceleration3 = acceleration(position + half_t * velocity2, velocity3);
+			const V velocity4 = velocity + delta_t * acceleration3;
+			const V acceleration4 = acceleration(position + delta_t * velocity3, velocity4);
+
+			const T sixth_t = delta_t / T(6);
+			position += sixth_t * (velocity1 + T(2) * (velocity2 + velocity3) + velocity4);
+			velocity += sixth_t * (acceleration1 + T(2) * (acceleration2 + acceleration3) + acceleration4);
+			velocity *= damping;
+		}
+	};
 }
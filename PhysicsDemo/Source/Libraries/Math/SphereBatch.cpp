@@ -0,0 +1,177 @@
+#include "SphereBatch.h"
+
+#include <bit>
+
+//the AVX2 kernel is built without /arch:AVX2 so the rest of the library runs anywhere, it is only called after checking the processor
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define JM_TARGET_AVX2
+#else
+#include <immintrin.h>
+#define JM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace jm::math
+{
+	namespace
+	{
+		//pairs whose centres are closer than this get the fallback normal
+		constexpr f32 MinSeparation = 1e-6f;
+
+		bool processor_has_avx2()
+		{
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+			{
+				return false;
+			}
+
+			//the processor must support AVX and the operating system must save the ymm registers
+			__cpuid(info, 1);
+			const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+			__cpuidex(info, 7, 0);
+			return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+
+		void collide_scalar(sphere_pair_batch const& pairs, sphere_contact_batch& contacts, uSize begin, uSize& touching)
+		{
+			for (uSize idx = begin; idx < pairs.size(); ++idx)
+			{
+				const f32 dx = pairs.b_x[idx] - pairs.a_x[idx];
+				const f32 dy = pairs.b_y[idx] - pairs.a_y[idx];
+				const f32 dz = pairs.b_z[idx] - pairs.a_z[idx];
+				const f32 distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+				const bool coincident = distance < MinSeparation;
+				const f32 inverse_distance = coincident ? 0.0f : 1.0f / distance;
+
+				contacts.normal_x[idx] = dx * inverse_distance;
+				contacts.normal_y[idx] = coincident ? 1.0f : dy * inverse_distance;
+				contacts.normal_z[idx] = dz * inverse_distance;
+				contacts.depth[idx] = pairs.a_radius[idx] + pairs.b_radius[idx] - distance;
+				touching += contacts.depth[idx] >= 0.0f ? 1 : 0;
+			}
+		}
+
+		uSize collide_sse(sphere_pair_batch const& pairs, sphere_contact_batch& contacts, uSize& touching)
+		{
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 min_separation = _mm_set1_ps(MinSeparation);
+			const __m128 one = _mm_set1_ps(1.0f);
+
+			uSize idx = 0;
+			for (; idx + 4 <= pairs.size(); idx += 4)
+			{
+				const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&pairs.b_x[idx]), _mm_loadu_ps(&pairs.a_x[idx]));
+				const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&pairs.b_y[idx]), _mm_loadu_ps(&pairs.a_y[idx]));
+				const __m128 dz = _mm_sub_ps(_mm_loadu_ps(&pairs.b_z[idx]), _mm_loadu_ps(&pairs.a_z[idx]));
+				const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+				//coincident centres zero the inverse distance and take the +y fallback
+				const __m128 coincident = _mm_cmplt_ps(distance, min_separation);
+				const __m128 inverse_distance = _mm_andnot_ps(coincident, _mm_div_ps(one, _mm_max_ps(distance, min_separation)));
+
+				_mm_storeu_ps(&contacts.normal_x[idx], _mm_mul_ps(dx, inverse_distance));
+				//the product is -0 for a tiny negative dy, so it is masked out rather than having 1 or-ed into its bits
+				_mm_storeu_ps(&contacts.normal_y[idx], _mm_or_ps(_mm_andnot_ps(coincident, _mm_mul_ps(dy, inverse_distance)), _mm_and_ps(coincident, one)));
+				_mm_storeu_ps(&contacts.normal_z[idx], _mm_mul_ps(dz, inverse_distance));
+				const __m128 depth = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(&pairs.a_radius[idx]), _mm_loadu_ps(&pairs.b_radius[idx])), distance);
+				_mm_storeu_ps(&contacts.depth[idx], depth);
+				touching += std::popcount(static_cast<u32>(_mm_movemask_ps(_mm_cmpge_ps(depth, zero))));
+			}
+			return idx;
+		}
+
+		JM_TARGET_AVX2 uSize collide_avx2(sphere_pair_batch const& pairs, sphere_contact_batch& contacts, uSize& touching)
+		{
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 min_separation = _mm256_set1_ps(MinSeparation);
+			const __m256 one = _mm256_set1_ps(1.0f);
+
+			uSize idx = 0;
+			for (; idx + 8 <= pairs.size(); idx += 8)
+			{
+				const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&pairs.b_x[idx]), _mm256_loadu_ps(&pairs.a_x[idx]));
+				const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&pairs.b_y[idx]), _mm256_loadu_ps(&pairs.a_y[idx]));
+				const __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(&pairs.b_z[idx]), _mm256_loadu_ps(&pairs.a_z[idx]));
+				const __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+
+				const __m256 coincident = _mm256_cmp_ps(distance, min_separation, _CMP_LT_OQ);
+				const __m256 inverse_distance = _mm256_andnot_ps(coincident, _mm256_div_ps(one, _mm256_max_ps(distance, min_separation)));
+
+				_mm256_storeu_ps(&contacts.normal_x[idx], _mm256_mul_ps(dx, inverse_distance));
+				_mm256_storeu_ps(&contacts.normal_y[idx], _mm256_blendv_ps(_mm256_mul_ps(dy, inverse_distance), one, coincident));
+				_mm256_storeu_ps(&contacts.normal_z[idx], _mm256_mul_ps(dz, inverse_distance));
+				const __m256 depth = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(&pairs.a_radius[idx]), _mm256_loadu_ps(&pairs.b_radius[idx])), distance);
+				_mm256_storeu_ps(&contacts.depth[idx], depth);
+				touching += std::popcount(static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(depth, zero, _CMP_GE_OQ))));
+			}
+			return idx;
+		}
+	}
+
+	simd_level get_best_simd_level()
+	{
+		static const simd_level best = processor_has_avx2() ? simd_level::AVX2 : simd_level::SSE;
+		return best;
+	}
+
+	void sphere_pair_batch::clear()
+	{
+		for (std::vector<f32>* field : { &a_x, &a_y, &a_z, &a_radius, &b_x, &b_y, &b_z, &b_radius })
+		{
+			field->clear();
+		}
+	}
+
+	void sphere_pair_batch::reserve(uSize count)
+	{
+		for (std::vector<f32>* field : { &a_x, &a_y, &a_z, &a_radius, &b_x, &b_y, &b_z, &b_radius })
+		{
+			field->reserve(count);
+		}
+	}
+
+	void sphere_pair_batch::push_back(sphere3<f32> const& a, sphere3<f32> const& b)
+	{
+		a_x.push_back(a.center.x);
+		a_y.push_back(a.center.y);
+		a_z.push_back(a.center.z);
+		a_radius.push_back(a.radius);
+		b_x.push_back(b.center.x);
+		b_y.push_back(b.center.y);
+		b_z.push_back(b.center.z);
+		b_radius.push_back(b.radius);
+	}
+
+	uSize collide(sphere_pair_batch const& pairs, sphere_contact_batch& contacts, simd_level level)
+	{
+		for (std::vector<f32>* field : { &contacts.normal_x, &contacts.normal_y, &contacts.normal_z, &contacts.depth })
+		{
+			field->resize(pairs.size());
+		}
+
+		JM_MATH_ASSERT(level != simd_level::AVX2 || get_best_simd_level() == simd_level::AVX2);
+
+		uSize touching = 0;
+		uSize done = 0;
+		switch (level)
+		{
+		case simd_level::AVX2:
+			done = collide_avx2(pairs, contacts, touching);
+			break;
+		case simd_level::SSE:
+			done = collide_sse(pairs, contacts, touching);
+			break;
+		default:
+			break;
+		}
+		collide_scalar(pairs, contacts, done, touching);
+		return touching;
+	}
+}
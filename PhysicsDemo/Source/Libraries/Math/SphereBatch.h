@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Geometry.h"
+
+namespace jm::math
+{
+	enum class simd_level
+	{
+		Scalar,
+		SSE, //4 pairs per instruction, always available on x64
+		AVX2 //8 pairs per instruction
+	};
+
+	//the widest level the running processor and operating system support
+	simd_level get_best_simd_level();
+
+	//candidate sphere pairs as structure of arrays, so a kernel loads the same field of consecutive pairs in one go
+	struct sphere_pair_batch
+	{
+		std::vector<f32> a_x, a_y, a_z, a_radius;
+		std::vector<f32> b_x, b_y, b_z, b_radius;
+
+		void clear();
+		void reserve(uSize count);
+		void push_back(sphere3<f32> const& a, sphere3<f32> const& b);
+		uSize size() const { return a_x.size(); }
+	};
+
+	//one entry per pair, depth is negative for separated pairs and the normal points from a to b
+	struct sphere_contact_batch
+	{
+		std::vector<f32> normal_x, normal_y, normal_z, depth;
+
+		uSize size() const { return depth.size(); }
+	};
+
+	//returns the number of touching pairs (depth >= 0). Concentric spheres get an arbitrary +y normal.
+	//level selects the kernel for benchmarking and must not exceed get_best_simd_level().
+	uSize collide(sphere_pair_batch const& pairs, sphere_contact_batch& contacts, simd_level level = get_best_simd_level());
+}
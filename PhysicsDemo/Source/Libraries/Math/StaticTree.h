@@ -0,0 +1,199 @@
+#pragma once
+
+#include "Geometry.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <future>
+#include <thread>
+
+namespace jm::math
+{
+	//Immutable bounding volume hierarchy built once with binned surface area heuristic splits. The upper levels are
+	//built in parallel, each task owns a disjoint range of the primitive order and claims its nodes atomically.
+	template <typename T>
+	class static_aabb_tree
+	{
+	public:
+		static constexpr u32 MaxLeafSize = 4;
+		static constexpr u32 BinCount = 16;
+		static constexpr u32 ParallelBuildThreshold = 4096; //smaller subtrees are not worth a task
+
+		static_aabb_tree() = default;
+
+		explicit static_aabb_tree(std::vector<aabb3<T>> primitive_bounds)
+			: primitives(std::move(primitive_bounds))
+			, order(primitives.size())
+			, nodes(primitives.empty() ? 0 : 2 * primitives.size() - 1)
+		{
+			if (primitives.empty())
+			{
+				return;
+			}
+
+			for (u32 idx = 0; idx < static_cast<u32>(order.size()); ++idx)
+			{
+				order[idx] = idx;
+			}
+
+			std::atomic<u32> node_count = 1;
+			const u32 max_parallel_depth = std::bit_width(std::max(1u, std::thread::hardware_concurrency()));
+			build(0, 0, static_cast<u32>(order.size()), 0, max_parallel_depth, node_count);
+			nodes.resize(node_count.load());
+		}
+
+		uSize get_primitive_count() const { return primitives.size(); }
+		uSize get_node_count() const { return nodes.size(); }
+
+		//calls callback(primitive) for every primitive whose bounds overlap bounds, stops early if it returns false
+		template <typename Fxn>
+		void query(aabb3<T> const& bounds, Fxn&& callback) const
+		{
+			if (nodes.empty())
+			{
+				return;
+			}
+
+			std::array<u32, 256> stack; //binned splits stay close to balanced, far shallower than this
+			uSize size = 0;
+			stack[size++] = 0;
+			while (size != 0)
+			{
+				node const& current = nodes[stack[--size]];
+				if (!intersect(current.bounds, bounds))
+				{
+					continue;
+				}
+
+				if (current.count != 0)
+				{
+					for (u32 idx = current.first; idx < current.first + current.count; ++idx)
+					{
+						if (intersect(primitives[order[idx]], bounds) && !callback(order[idx]))
+						{
+							return;
+						}
+					}
+				}
+				else
+				{
+					JM_MATH_ASSERT(size + 2 <= stack.size());
+					stack[size++] = current.first;
+					stack[size++] = current.first + 1;
+				}
+			}
+		}
+
+	private:
+		struct node
+		{
+			aabb3<T> bounds;
+			u32 first = 0; //first primitive for a leaf, left child for an interior node (right is first + 1)
+			u32 count = 0; //primitives in a leaf, zero for an interior node
+		};
+
+		struct bin
+		{
+			aabb3<T> bounds{ vector3<T>(math::infinity<T>()), vector3<T>(-math::infinity<T>()) };
+			u32 count = 0;
+		};
+
+		void build(u32 index, u32 begin, u32 end, u32 depth, u32 max_parallel_depth, std::atomic<u32>& node_count)
+		{
+			aabb3<T> bounds{ vector3<T>(math::infinity<T>()), vector3<T>(-math::infinity<T>()) };
+			aabb3<T> centroid_bounds = bounds;
+			for (u32 idx = begin; idx < end; ++idx)
+			{
+				bounds = merge(bounds, primitives[order[idx]]);
+				const vector3<T> c = center(primitives[order[idx]]);
+				centroid_bounds = merge(centroid_bounds, { c, c });
+			}
+
+			nodes[index] = { bounds, begin, end - begin };
+			const u32 count = end - begin;
+			if (count <= MaxLeafSize)
+			{
+				return;
+			}
+
+			const vector3<T> extent = size(centroid_bounds);
+			const glm::length_t axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+			u32 middle = begin + count / 2;
+
+			if (extent[axis] > T(0))
+			{
+				const T bin_scale = T(BinCount) / extent[axis];
+				auto bin_of = [&](u32 primitive)
+				{
+					const u32 slot = static_cast<u32>((center(primitives[primitive])[axis] - centroid_bounds.min[axis]) * bin_scale);
+					return std::min(slot, BinCount - 1);
+				};
+
+				std::array<bin, BinCount> bins{};
+				for (u32 idx = begin; idx < end; ++idx)
+				{
+					bin& target = bins[bin_of(order[idx])];
+					target.bounds = merge(target.bounds, primitives[order[idx]]);
+					++target.count;
+				}
+
+				//cost of splitting after each bin, from a left to right and a right to left sweep
+				std::array<T, BinCount - 1> costs{};
+				bin left;
+				for (u32 split = 0; split < BinCount - 1; ++split)
+				{
+					left.bounds = merge(left.bounds, bins[split].bounds);
+					left.count += bins[split].count;
+					costs[split] = left.count == 0 ? math::infinity<T>() : surface_area(left.bounds) * T(left.count);
+				}
+				bin right;
+				for (u32 split = BinCount - 1; split > 0; --split)
+				{
+					right.bounds = merge(right.bounds, bins[split].bounds);
+					right.count += bins[split].count;
+					costs[split - 1] += right.count == 0 ? math::infinity<T>() : surface_area(right.bounds) * T(right.count);
+				}
+
+				const u32 best_split = static_cast<u32>(std::min_element(costs.begin(), costs.end()) - costs.begin());
+				const T leaf_cost = surface_area(bounds) * T(count);
+				if (costs[best_split] >= leaf_cost && count <= 4 * MaxLeafSize)
+				{
+					return;
+				}
+
+				middle = static_cast<u32>(std::partition(order.begin() + begin, order.begin() + end, [&](u32 primitive) { return bin_of(primitive) <= best_split; }) - order.begin());
+			}
+
+			//coincident centroids, or every centroid in one bin, fall back to a median split
+			if (middle == begin || middle == end)
+			{
+				middle = begin + count / 2;
+				std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](u32 a, u32 b)
+					{
+						return center(primitives[a])[axis] < center(primitives[b])[axis];
+					});
+			}
+
+			const u32 left_child = node_count.fetch_add(2);
+			nodes[index].first = left_child;
+			nodes[index].count = 0;
+
+			if (count > ParallelBuildThreshold && depth < max_parallel_depth)
+			{
+				auto left_task = std::async(std::launch::async, [&]() { build(left_child, begin, middle, depth + 1, max_parallel_depth, node_count); });
+				build(left_child + 1, middle, end, depth + 1, max_parallel_depth, node_count);
+				left_task.get();
+			}
+			else
+			{
+				build(left_child, begin, middle, depth + 1, max_parallel_depth, node_count);
+				build(left_child + 1, middle, end, depth + 1, max_parallel_depth, node_count);
+			}
+		}
+
+		std::vector<aabb3<T>> primitives;
+		std::vector<u32> order;
+		std::vector<node> nodes;
+	};
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Gjk.h"
+
+namespace jm::math
+{
+    template <typename T>
+    struct toi_output
+    {
+        T time = T(1); //fraction of the translation travelled before contact
+        vector3<T> normal{}; //unit length, points from a to b at the time of impact
+        bool hit = false;
+        u32 iterations = 0;
+    };
+
+    //a shape moved by offset without copying it, so conservative advancement can step a shape along its path
+    template <typename T, typename Shape>
+    struct translated_shape
+    {
+        Shape const& shape;
+        vector3<T> offset;
+    };
+
+    template <typename T, typename Shape>
+    vector3<T> support(translated_shape<T, Shape> const& a, vector3<T> const& direction)
+    {
+        return support(a.shape, direction) + a.offset;
+    };
+
+    //Sphere a moving by translation against a stationary sphere b, solved exactly. Pairs that already overlap at the start
+    //are left to the discrete test, a hit stops tolerance short of touching so the next step starts separated.
+    template <typename T>
+    toi_output<T> time_of_impact(sphere3<T> const& a, vector3<T> const& translation, sphere3<T> const& b, T tolerance)
+    {
+        toi_output<T> output;
+
+        const vector3<T> offset = b.center - a.center;
+        const T radius = a.radius + b.radius + tolerance;
+        const T c = dot(offset, offset) - radius * radius;
+        const T half_b = dot(offset, translation);
+        const T a2 = dot(translation, translation);
+        if (dot(offset, offset) < (a.radius + b.radius) * (a.radius + b.radius) || half_b <= T(0) || a2 <= epsilon<T>())
+        {
+            return output;
+        }
+
+        //|offset - translation t| = radius, earliest root
+        const T discriminant = half_b * half_b - a2 * c;
+        if (discriminant < T(0))
+        {
+            return output;
+        }
+
+        const T time = std::max((half_b - std::sqrt(discriminant)) / a2, T(0));
+        if (time > T(1))
+        {
+            return output;
+        }
+
+        output.time = time;
+        output.normal = normalize(offset - translation * time);
+        output.hit = true;
+        output.iterations = 1;
+        return output;
+    }
+
+    //Conservative advancement of a moving by translation against a stationary b, each the core shape inflated by a radius.
+    //Only translation is swept, so the separation is convex in time and stepping by separation over approach speed never
+    //passes the first contact. Stops once the shapes are within tolerance, overlapping starts are left to the discrete test.
+    template <typename T, typename ShapeA, typename ShapeB>
+    toi_output<T> time_of_impact(ShapeA const& a, vector3<T> const& translation, ShapeB const& b, T tolerance, T a_radius = T(0), T b_radius = T(0))
+    {
+        constexpr u32 MaxIterations = 20;
+
+        toi_output<T> output;
+        gjk_cache<T> cache;
+        vector3<T> normal{};
+        T time = T(0);
+        while (output.iterations < MaxIterations)
+        {
+            ++output.iterations;
+
+            const gjk_output<T> distance = gjk_distance(translated_shape<T, ShapeA>{ a, translation * time }, b, cache);
+            const T separation = distance.distance - a_radius - b_radius;
+            if (distance.overlapping || distance.distance <= epsilon<T>() || (time == T(0) && separation < T(0)))
+            {
+                return output;
+            }
+
+            //moving apart along the closest direction means moving apart for the rest of the translation
+            normal = (distance.point_b - distance.point_a) / distance.distance;
+            const T approach = dot(translation, normal);
+            if (approach <= T(0))
+            {
+                return output;
+            }
+
+            if (separation <= tolerance)
+            {
+                output.time = time;
+                output.normal = normal;
+                output.hit = true;
+                return output;
+            }
+
+            time += (separation - T(0.5) * tolerance) / approach;
+            if (time > T(1))
+            {
+                return output;
+            }
+        }
+
+        //out of iterations while still closing in, report where it got to so the body at least stops short
+        output.time = time;
+        output.normal = normal;
+        output.hit = true;
+        return output;
+    }
+}
@@ -0,0 +1,46 @@
+#include "Broadphase.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace jm
+{
+	void broadphase::find_pair_changes(std::vector<collision_proxy> const& proxies, collision_pair_changes& changes)
+	{
+		find_pairs(proxies, current_pairs);
+		std::sort(current_pairs.begin(), current_pairs.end());
+
+		changes.added.clear();
+		changes.removed.clear();
+		std::set_difference(current_pairs.begin(), current_pairs.end(), previous_pairs.begin(), previous_pairs.end(), std::back_inserter(changes.added));
+		std::set_difference(previous_pairs.begin(), previous_pairs.end(), current_pairs.begin(), current_pairs.end(), std::back_inserter(changes.removed));
+
+		std::swap(previous_pairs, current_pairs);
+	}
+
+	void brute_force_broadphase::find_pairs(std::vector<collision_proxy> const& proxies, std::vector<collision_pair>& pairs)
+	{
+		pairs.clear();
+		stats = { proxies.size(), 0, 0 };
+
+		for (size_t idx = 0; idx < proxies.size(); ++idx)
+		{
+			auto& b = proxies[idx];
+			for (size_t jdx = idx + 1; jdx < proxies.size(); ++jdx)
+			{
+				auto& a = proxies[jdx];
+				if (!can_collide(a.filter, b.filter))
+				{
+					++stats.filtered_pairs;
+				}
+				else if (math::intersect(a.bounds, b.bounds))
+				{
+					pairs.push_back(make_collision_pair(a.entity, b.entity));
+				}
+			}
+		}
+
+		stats.tested_pairs = proxies.size() * (proxies.size() - (proxies.empty() ? 0 : 1)) / 2 - stats.filtered_pairs;
+		stats.candidate_pairs = pairs.size();
+	}
+}
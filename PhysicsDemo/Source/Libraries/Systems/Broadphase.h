@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Entity.h"
+#include "Math/Geometry.h"
+
+namespace jm
+{
+	//group is the layers a proxy sits on and mask the layers it collides with, a pair is kept only if each is in the other's mask.
+	//Broadphases check filters before bounds when a pair could first appear, so change a filter only while its proxy is apart.
+	struct collision_filter
+	{
+		u32 group = 1;
+		u32 mask = ~u32(0);
+	};
+
+	inline bool can_collide(collision_filter const& first, collision_filter const& second)
+	{
+		return (first.group & second.mask) != 0 && (second.group & first.mask) != 0;
+	}
+
+	struct collision_proxy
+	{
+		entity_id entity;
+		math::aabb3<f32> bounds;
+		collision_filter filter{};
+	};
+
+	//a is always the lower entity id so the same two bodies always make the same pair
+	struct collision_pair
+	{
+		entity_id a;
+		entity_id b;
+	};
+
+	inline collision_pair make_collision_pair(entity_id first, entity_id second)
+	{
+		return first < second ? collision_pair{ first, second } : collision_pair{ second, first };
+	}
+
+	inline bool operator == (collision_pair const& left, collision_pair const& right)
+	{
+		return left.a == right.a && left.b == right.b;
+	}
+
+	inline bool operator < (collision_pair const& left, collision_pair const& right)
+	{
+		return left.a < right.a || (left.a == right.a && left.b < right.b);
+	}
+
+	struct collision_pair_changes
+	{
+		std::vector<collision_pair> added; //pairs that started overlapping since the last update
+		std::vector<collision_pair> removed; //pairs that stopped overlapping or lost a proxy since the last update
+	};
+
+	struct broadphase_stats
+	{
+		uSize proxies = 0;
+		uSize tested_pairs = 0; //bounds tests performed
+		uSize candidate_pairs = 0; //pairs handed to the narrowphase
+		uSize filtered_pairs = 0; //pairs rejected by their collision filters without a bounds test
+	};
+
+	class broadphase
+	{
+	public:
+		virtual ~broadphase() = default;
+
+		//writes every pair of overlapping proxy bounds, replacing the contents of pairs
+		virtual void find_pairs(std::vector<collision_proxy> const& proxies, std::vector<collision_pair>& pairs) = 0;
+
+		//writes only the pairs that changed since the previous call, by default by diffing full pair lists.
+		//Every call advances the broadphase a tick, so use either this or find_pairs on a given instance.
+		virtual void find_pair_changes(std::vector<collision_proxy> const& proxies, collision_pair_changes& changes);
+
+		broadphase_stats const& get_stats() const { return stats; }
+
+	protected:
+		broadphase_stats stats;
+
+	private:
+		std::vector<collision_pair> previous_pairs;
+		std::vector<collision_pair> current_pairs;
+	};
+
+	//reference implementation, tests every proxy against every other proxy
+	class brute_force_broadphase final : public broadphase
+	{
+	public:
+		void find_pairs(std::vector<collision_proxy> const& proxies, std::vector<collision_pair>& pairs) override;
+	};
+}
@@ -1,66 +1,580 @@
 #include "Collision.h"
 #include "Components.h"
+#include "Shapes.h"
+#include "UniformGrid.h"
+#include "SweepAndPrune.h"
+#include "TreeBroadphase.h"
+#include "Simulation.h"
 #include "Math/Geometry.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace jm
 {
-    struct SphereCollider
+    namespace
     {
-        entity_id entity;
-        math::sphere3<f32> sphere;
-    };
-    struct BoxCollider
+        collision_filter get_filter(entity_registry const& registry, entity_id entity)
+        {
+            const collision_filter_component* filter = registry.try_get<collision_filter_component>(entity);
+            return filter != nullptr ? *filter : collision_filter{};
+        }
+
+        //a moving by translation against stationary b
+        math::toi_output<f32> time_of_impact(shape_component a_shape, spatial3_component const& a_spatial, math::vector3_f32 const& translation,
+            shape_component b_shape, spatial3_component const& b_spatial, f32 tolerance)
+        {
+            const math::sphere3<f32> a_sphere = make_sphere(a_spatial);
+            const math::sphere3<f32> b_sphere = make_sphere(b_spatial);
+            if (a_shape == shape_component::Sphere && b_shape == shape_component::Sphere)
+            {
+                return math::time_of_impact(a_sphere, translation, b_sphere, tolerance);
+            }
+            else if (a_shape == shape_component::Sphere)
+            {
+                return math::time_of_impact(a_sphere.center, translation, make_box(b_spatial), tolerance, a_sphere.radius, 0.0f);
+            }
+            else if (b_shape == shape_component::Sphere)
+            {
+                return math::time_of_impact(make_box(a_spatial), translation, b_sphere.center, tolerance, 0.0f, b_sphere.radius);
+            }
+            return math::time_of_impact(make_box(a_spatial), translation, make_box(b_spatial), tolerance);
+        }
+
+        void rebuild_sleeping_tree(entity_registry& registry, collision_world& world)
+        {
+            auto sleeping_view = registry.view<const sleeping_component, const shape_component, const spatial3_component>();
+
+            std::vector<entity_id> entities;
+            std::vector<collision_filter> filters;
+            std::vector<math::aabb3<f32>> bounds;
+            for (auto&& [entity, sleeping, shape, spatial] : sleeping_view.each())
+            {
+                entities.push_back(entity);
+                filters.push_back(get_filter(registry, entity));
+                bounds.push_back(make_bounds(shape, spatial));
+            }
+
+            world.sleeping_tree = filtered_aabb_tree(entities, filters, bounds);
+            world.sleeping_tree_dirty = false;
+        }
+
+        void refresh_sleeping_tree(entity_registry& registry, collision_world& world)
+        {
+            //removing the tag outside of here wakes bodies too, which shows as a change in the sleeping count
+            if (world.sleeping_tree_dirty || registry.storage<sleeping_component>().size() != world.sleeping_tree.get_primitive_count())
+            {
+                rebuild_sleeping_tree(registry, world);
+            }
+        }
+
+        void rebuild_body_tree(entity_registry& registry, collision_world& world)
+        {
+            std::vector<entity_id> entities;
+            std::vector<collision_filter> filters;
+            std::vector<math::aabb3<f32>> bounds;
+            for (auto&& [entity, body, spatial] : get_awake_bodies(registry).each())
+            {
+                if (const shape_component* shape = registry.try_get<shape_component>(entity))
+                {
+                    entities.push_back(entity);
+                    filters.push_back(get_filter(registry, entity));
+                    bounds.push_back(make_bounds(*shape, spatial));
+                }
+            }
+
+            world.body_tree = filtered_aabb_tree(entities, filters, bounds);
+        }
+
+        //wakes every body of the islands in world.waking_islands
+        void wake_islands(entity_registry& registry, collision_world& world)
+        {
+            if (world.waking_islands.empty())
+            {
+                return;
+            }
+
+            std::sort(world.waking_islands.begin(), world.waking_islands.end());
+            world.waking_islands.erase(std::unique(world.waking_islands.begin(), world.waking_islands.end()), world.waking_islands.end());
+
+            wake_sleeping_islands(registry, world.waking_islands, world.waking_entities);
+            world.woken_bodies += world.waking_entities.size();
+            world.waking_islands.clear();
+            world.sleeping_tree_dirty = true;
+        }
+
+        //wakes the islands of the sleeping bodies in pairs
+        void wake_touched_islands(entity_registry& registry, collision_world& world, std::vector<collision_pair> const& pairs)
+        {
+            auto& sleeping_storage = registry.storage<sleeping_component>();
+            if (sleeping_storage.empty())
+            {
+                return;
+            }
+
+            for (collision_pair const& pair : pairs)
+            {
+                for (entity_id entity : { pair.a, pair.b })
+                {
+                    if (sleeping_storage.contains(entity))
+                    {
+                        world.waking_islands.push_back(sleeping_storage.get(entity).island);
+                    }
+                }
+            }
+            wake_islands(registry, world);
+        }
+
+        //Wakes the islands of sleeping bodies joined to an awake body. Bodies that fell asleep together through a joint share an
+        //island, so this only happens when one of them was woken on its own.
+        void wake_joined_islands(entity_registry& registry, collision_world& world)
+        {
+            auto& sleeping_storage = registry.storage<sleeping_component>();
+            if (sleeping_storage.empty())
+            {
+                return;
+            }
+
+            for (auto&& [entity, joint] : registry.view<const joint_component>().each())
+            {
+                if (joint.b == null_entity_id || !registry.valid(joint.a) || !registry.valid(joint.b))
+                {
+                    continue;
+                }
+
+                const bool a_sleeping = sleeping_storage.contains(joint.a);
+                const bool b_sleeping = sleeping_storage.contains(joint.b);
+                const entity_id awake = a_sleeping ? joint.b : joint.a;
+                if (a_sleeping != b_sleeping && registry.all_of<linear_body3_component>(awake))
+                {
+                    world.waking_islands.push_back(sleeping_storage.get(a_sleeping ? joint.a : joint.b).island);
+                }
+            }
+            wake_islands(registry, world);
+        }
+
+        //Islands whose bodies have all been slower than sleep_velocity for sleep_time go to sleep together. The impulse solver's
+        //are taken from last update before the new contacts are found, since the velocity a resting body leaves the solve with
+        //cancels the next step of gravity, only the velocity integrate just moved it with shows whether it is really at rest.
+        //Substeps and XPBD move the bodies within the solve and leave a resting body still, so with use_solved_velocities the
+        //velocity the solve left is the one to test.
+        template <typename Solver>
+        void update_sleeping(entity_registry& registry, collision_world& world, Solver const& solver, bool use_solved_velocities, f32 delta_time)
+        {
+            if (world.settings.sleep_time <= 0.0f)
+            {
+                return;
+            }
+
+            const f32 sleep_speed_squared = world.settings.sleep_velocity * world.settings.sleep_velocity;
+            for (u32 island = 0; island < solver.get_island_count(); ++island)
+            {
+                const std::span<entity_id const> entities = solver.get_island_entities(island);
+                const std::span<math::vector3_f32 const> solved_velocities = solver.get_island_velocities(island);
+
+                f32 island_rest_time = std::numeric_limits<f32>::max();
+                for (uSize slot = 0; slot < entities.size(); ++slot)
+                {
+                    const entity_id entity = entities[slot];
+                    if (!registry.valid(entity) || !registry.all_of<linear_body3_component>(entity))
+                    {
+                        island_rest_time = 0.0f;
+                        break;
+                    }
+
+                    const uSize entity_index = static_cast<uSize>(entt::to_entity(entity));
+                    if (entity_index >= world.rest_times.size())
+                    {
+                        world.rest_times.resize(entity_index + 1, 0.0f);
+                    }
+
+                    linear_body3_component const& linear = registry.get<linear_body3_component>(entity);
+                    const math::vector3_f32 velocity = use_solved_velocities ? solved_velocities[slot] : linear.velocity;
+                    f32& rest_time = world.rest_times[entity_index];
+                    const rotational_body3_component* rotational = registry.try_get<rotational_body3_component>(entity);
+                    const bool turning = rotational != nullptr && glm::dot(rotational->velocity, rotational->velocity) >= sleep_speed_squared;
+                    rest_time = glm::dot(velocity, velocity) < sleep_speed_squared && !turning ? rest_time + delta_time : 0.0f;
+                    island_rest_time = std::min(island_rest_time, rest_time);
+                }
+
+                if (island_rest_time < world.settings.sleep_time)
+                {
+                    continue;
+                }
+
+                for (entity_id entity : entities)
+                {
+                    registry.get<linear_body3_component>(entity).velocity = math::zero3;
+                    if (rotational_body3_component* rotational = registry.try_get<rotational_body3_component>(entity))
+                    {
+                        rotational->velocity = math::zero3;
+                    }
+                    registry.emplace<sleeping_component>(entity, world.next_sleeping_island);
+                    world.rest_times[static_cast<uSize>(entt::to_entity(entity))] = 0.0f;
+                }
+                ++world.next_sleeping_island;
+                world.sleeping_tree_dirty = true;
+            }
+        }
+
+        //Awake bodies against each other, the baked statics and the sleeping bodies. With a sweep_time the proxies cover the
+        //motion at their current velocity over that time, inflated by margin, so the pairs hold everything that may touch.
+        void find_pairs(entity_registry& registry, collision_world& world, f32 sweep_time, f32 margin)
+        {
+            refresh_sleeping_tree(registry, world);
+
+            //create proxies, only awake bodies move so only they go through the broadphase
+            world.proxies.clear();
+            for (auto&& [entity, body, spatial] : get_awake_bodies(registry).each())
+            {
+                if (const shape_component* shape = registry.try_get<shape_component>(entity))
+                {
+                    math::aabb3<f32> bounds = make_bounds(*shape, spatial);
+                    if (sweep_time > 0.0f)
+                    {
+                        const math::vector3_f32 motion = body.velocity * sweep_time;
+                        bounds = math::inflate(math::merge(bounds, { bounds.min + motion, bounds.max + motion }), margin);
+                    }
+                    world.proxies.push_back({ entity, bounds, get_filter(registry, entity) });
+                }
+            }
+
+            world.pair_finder->find_pairs(world.proxies, world.pairs);
+
+            //bodies against the baked statics, statics never test against each other. Statics a proxy's filter rules out are
+            //passed over a layer at a time, before any bounds test.
+            const uSize dynamic_pair_count = world.pairs.size();
+            uSize static_filtered_pairs = 0;
+            for (collision_proxy const& proxy : world.proxies)
+            {
+                static_filtered_pairs += world.static_tree.query(proxy.filter, proxy.bounds,
+                    [&](entity_id other) { world.pairs.push_back(make_collision_pair(proxy.entity, other)); });
+            }
+            world.static_stats = { world.static_tree.get_primitive_count(), 0, world.pairs.size() - dynamic_pair_count, static_filtered_pairs };
+
+            //awake bodies against sleeping ones, a pair that turns out to touch wakes the sleeping island
+            for (collision_proxy const& proxy : world.proxies)
+            {
+                world.sleeping_tree.query(proxy.filter, proxy.bounds, [&](entity_id other) { world.pairs.push_back(make_collision_pair(proxy.entity, other)); });
+            }
+        }
+    }
+
+    collision_world::collision_world(collision_settings const& settings)
+        : settings(settings)
+        , workers(std::make_unique<worker_pool>())
+        , pair_finder(make_broadphase(settings, *workers))
+        , solver(*workers)
     {
-        entity_id entity;
-        math::box3<f32> box;
-    };
+    }
+
+    void collision_world::set_broadphase(broadphase_type type)
+    {
+        settings.broadphase = type;
+        pair_finder = make_broadphase(settings, *workers);
+    }
 
-    void resolve_collisions(entity_registry& registry)
+    void collision_world::bake_static_bodies(entity_registry const& registry)
+    {
+        auto static_view = registry.view<const shape_component, const spatial3_component>(entt::exclude<linear_body3_component>);
+
+        std::vector<entity_id> entities;
+        std::vector<collision_filter> filters;
+        std::vector<math::aabb3<f32>> bounds;
+        for (auto&& [entity, shape, spatial] : static_view.each())
+        {
+            entities.push_back(entity);
+            filters.push_back(get_filter(registry, entity));
+            bounds.push_back(make_bounds(shape, spatial));
+        }
+
+        static_tree = filtered_aabb_tree(entities, filters, bounds);
+    }
+
+    std::unique_ptr<broadphase> make_broadphase(collision_settings const& settings, worker_pool& workers)
+    {
+        switch (settings.broadphase)
+        {
+        case broadphase_type::UniformGrid:
+            return std::make_unique<uniform_grid_broadphase>(workers, settings.grid_cell_size, settings.grid_thread_count);
+        case broadphase_type::SweepAndPrune:
+            return std::make_unique<sweep_and_prune_broadphase>();
+        case broadphase_type::DynamicTree:
+            return std::make_unique<dynamic_tree_broadphase>(settings.tree_margin);
+        default:
+            return std::make_unique<brute_force_broadphase>();
+        }
+    }
+
+    void resolve_collisions(entity_registry& registry, collision_world& world, f32 delta_time)
     {
-        //create colliders
         auto shape_entity_view = registry.view<const shape_component, const spatial3_component>();
-       
-        std::vector<SphereCollider> spheres;
-        std::vector<BoxCollider> boxes;
+        update_sleeping(registry, world, world.solver, world.settings.solver.substeps > 0, delta_time);
 
-        for (auto&& [entity, shape, spatial] : shape_entity_view.each())
+        find_pairs(registry, world, 0.0f, 0.0f);
+
+        //check for collisions
+        world.contacts.clear();
+        std::swap(world.manifolds, world.previous_manifolds);
+        world.manifolds.clear();
+        world.sphere_pairs.clear();
+        world.sphere_batch.clear();
+        world.box_sphere_pairs.clear();
+        world.simplex_cache.begin_update();
+        for (collision_pair const& pair : world.pairs)
         {
-            switch (shape)
+            auto [a_shape, a_spatial] = shape_entity_view.get(pair.a);
+            auto [b_shape, b_spatial] = shape_entity_view.get(pair.b);
+
+            if (a_shape == shape_component::Sphere && b_shape == shape_component::Sphere)
             {
-            case shape_component::Sphere:
-                spheres.push_back({ entity, math::sphere3{spatial.position, 1.0f} });  //assume unit radius spheres
-                break;
-            default:
-                break;
+                world.sphere_pairs.push_back(pair);
+                world.sphere_batch.push_back(make_sphere(a_spatial), make_sphere(b_spatial));
+            }
+            else if (a_shape == shape_component::Sphere || b_shape == shape_component::Sphere)
+            {
+                world.box_sphere_pairs.push_back(a_shape == shape_component::Sphere ? collision_pair{ pair.b, pair.a } : pair);
+            }
+            else
+            {
+                //GJK warm started from the pair's last simplex settles a separated pair in an iteration or two, only boxes that
+                //overlap pay for the fifteen axes and the clipping that builds their manifold
+                const math::box3<f32> a_box = make_box(a_spatial);
+                const math::box3<f32> b_box = make_box(b_spatial);
+                const math::gjk_output<f32> distance = math::gjk_distance(a_box, b_box, world.simplex_cache.visit(pair).value);
+                if (!distance.overlapping && distance.distance > math::epsilon<f32>())
+                {
+                    continue;
+                }
+
+                math::contact_manifold3<f32> manifold;
+                if (math::collide(a_box, b_box, manifold))
+                {
+                    world.contacts.push_back(pair);
+                    world.manifolds.push_back(manifold);
+                }
             }
         }
 
+        world.simplex_cache.end_update([](collision_pair const&, math::gjk_cache<f32> const&) {});
 
-        //check for collisions
-        for (size_t idx = 0; idx < spheres.size(); ++idx)
+        if (math::collide(world.sphere_batch, world.sphere_contacts) > 0)
         {
-            auto& b = spheres[idx];
-            for (size_t jdx = idx + 1; jdx < spheres.size(); ++jdx)
+            for (uSize idx = 0; idx < world.sphere_pairs.size(); ++idx)
             {
-                auto& a = spheres[jdx];
-                if (math::intersect(a.sphere, b.sphere))
+                const f32 depth = world.sphere_contacts.depth[idx];
+                if (depth < 0.0f)
                 {
-                    //do something
+                    continue;
                 }
+
+                //single point halfway between the two surfaces along the normal
+                math::contact_manifold3<f32> manifold;
+                manifold.normal = { world.sphere_contacts.normal_x[idx], world.sphere_contacts.normal_y[idx], world.sphere_contacts.normal_z[idx] };
+                const math::vector3_f32 a_center{ world.sphere_batch.a_x[idx], world.sphere_batch.a_y[idx], world.sphere_batch.a_z[idx] };
+                manifold.points[0] = { a_center + manifold.normal * (world.sphere_batch.a_radius[idx] - 0.5f * depth), depth, 0 };
+                manifold.point_count = 1;
+
+                world.contacts.push_back(world.sphere_pairs[idx]);
+                world.manifolds.push_back(manifold);
+            }
+        }
+
+        std::sort(world.box_sphere_pairs.begin(), world.box_sphere_pairs.end());
+        for (uSize begin = 0, end = 0; begin < world.box_sphere_pairs.size(); begin = end)
+        {
+            const entity_id box_entity = world.box_sphere_pairs[begin].a;
+            world.box_spheres.clear();
+            for (end = begin; end < world.box_sphere_pairs.size() && world.box_sphere_pairs[end].a == box_entity; ++end)
+            {
+                world.box_spheres.push_back(make_sphere(shape_entity_view.get<const spatial3_component>(world.box_sphere_pairs[end].b)));
+            }
+
+            const math::box3<f32> box = make_box(shape_entity_view.get<const spatial3_component>(box_entity));
+            if (math::collide(world.box_spheres, box, world.box_sphere_manifolds) == 0)
+            {
+                continue;
             }
 
-            for (size_t jdx = idx + 1; jdx < boxes.size(); ++jdx)
+            for (uSize idx = begin; idx < end; ++idx)
             {
-                auto& a = boxes[jdx];
-                if (math::intersect(b.sphere, a.box))
+                math::contact_manifold3<f32>& manifold = world.box_sphere_manifolds[idx - begin];
+                if (manifold.point_count == 0)
+                {
+                    continue;
+                }
+
+                //manifolds come back pointing from the sphere to the box, flip them when the box is a
+                const collision_pair pair = make_collision_pair(world.box_sphere_pairs[idx].a, world.box_sphere_pairs[idx].b);
+                if (pair.a == box_entity)
                 {
-                    //do something
+                    manifold.normal = -manifold.normal;
                 }
+                world.contacts.push_back(pair);
+                world.manifolds.push_back(manifold);
             }
+        }
 
+        //woken bodies join this update's solve, the rest of their island joins from the next update
+        world.woken_bodies = 0;
+        wake_touched_islands(registry, world, world.contacts);
+        wake_joined_islands(registry, world);
+
+        //carry impulses over from last update, the solver then starts from them rather than from zero
+        world.warm_started_points = 0;
+        world.manifold_indices.begin_update();
+        for (uSize idx = 0; idx < world.contacts.size(); ++idx)
+        {
+            auto visit = world.manifold_indices.visit(world.contacts[idx]);
+            if (!visit.inserted)
+            {
+                world.warm_started_points += math::warm_start(world.previous_manifolds[visit.value], world.manifolds[idx], world.settings.contact_match_distance);
+            }
+            visit.value = static_cast<u32>(idx);
         }
+        world.manifold_indices.end_update([](collision_pair const&, u32) {});
+
+        world.contact_cache.update(world.contacts, world.contact_events);
 
+        world.solver.solve(registry, world.contacts, world.manifolds, world.settings.solver, delta_time);
+    }
 
-        //resolve collisions
+    void simulate(entity_registry& registry, collision_world& world, f32 delta_time)
+    {
+        if (world.settings.solver_mode == solver_type::Xpbd)
+        {
+            store_previous_poses(registry);
+            step_xpbd(registry, world, delta_time);
+            return;
+        }
+
+        if (world.settings.ccd_fast_bodies)
+        {
+            update_continuous_bodies(registry, delta_time);
+        }
+        store_previous_poses(registry);
+        integrate(registry, delta_time);
+        resolve_continuous_collisions(registry, world, delta_time);
+        resolve_collisions(registry, world, delta_time);
+    }
+
+    void step_xpbd(entity_registry& registry, collision_world& world, f32 delta_time)
+    {
+        find_pairs(registry, world, delta_time, world.settings.xpbd.pair_margin);
+        world.woken_bodies = 0;
+        wake_joined_islands(registry, world);
+
+        //the step has no room to take bodies in part way through, so ones woken by the first substep's contacts join the next
+        world.xpbd.step(registry, world.pairs, world.settings.xpbd, delta_time, world.contacts);
+        wake_touched_islands(registry, world, world.xpbd.get_first_touching());
+        integrate_rotations(registry, delta_time); //the projections only move positions
+        update_sleeping(registry, world, world.xpbd, true, delta_time);
+        world.contact_cache.update(world.contacts, world.contact_events);
+
+        //nothing to warm start from, drop the impulse solver's manifolds so switching back starts clean
+        world.manifolds.clear();
+        world.manifold_indices.clear();
+        world.simplex_cache.clear();
+        world.warm_started_points = 0;
+        world.continuous_impacts = 0;
+    }
+
+    void resolve_continuous_collisions(entity_registry& registry, collision_world& world, f32 delta_time)
+    {
+        auto continuous_view = registry.view<spatial3_component, linear_body3_component, const continuous_collision_component, const shape_component>(entt::exclude<sleeping_component>);
+        auto shape_entity_view = registry.view<const shape_component, const spatial3_component>();
+
+        world.continuous_impacts = 0;
+        bool body_tree_built = false;
+        for (auto&& [entity, spatial, body, continuous, shape] : continuous_view.each())
+        {
+            math::vector3_f32 translation = spatial.position - continuous.start_position;
+            if (glm::dot(translation, translation) < world.settings.ccd_motion_threshold * world.settings.ccd_motion_threshold)
+            {
+                continue;
+            }
+
+            //the other bodies are taken where integrate left them, bodies swept earlier in the loop keep the bounds they had then
+            if (!body_tree_built)
+            {
+                refresh_sleeping_tree(registry, world);
+                rebuild_body_tree(registry, world);
+                body_tree_built = true;
+            }
+
+            const collision_filter filter = get_filter(registry, entity);
+            spatial.position = continuous.start_position;
+            f32 remaining_time = delta_time;
+            for (u32 substep = 0; substep < world.settings.ccd_max_substeps; ++substep)
+            {
+                //everything the body could reach this substep
+                const math::aabb3<f32> start_bounds = make_bounds(shape, spatial);
+                const math::aabb3<f32> swept_bounds = math::merge(start_bounds, { start_bounds.min + translation, start_bounds.max + translation });
+
+                math::toi_output<f32> earliest;
+                const auto sweep_against = [&](entity_id other)
+                    {
+                        auto [other_shape, other_spatial] = shape_entity_view.get(other);
+                        const math::toi_output<f32> impact = time_of_impact(shape, spatial, translation, other_shape, other_spatial, world.settings.ccd_tolerance);
+                        if (impact.hit && impact.time < earliest.time)
+                        {
+                            earliest = impact;
+                        }
+                    };
+                world.static_tree.query(filter, swept_bounds, sweep_against);
+                world.body_tree.query(filter, swept_bounds, [&](entity_id other)
+                    {
+                        if (other != entity)
+                        {
+                            sweep_against(other);
+                        }
+                    });
+                world.sleeping_tree.query(filter, swept_bounds, sweep_against);
+
+                if (!earliest.hit)
+                {
+                    spatial.position += translation;
+                    break;
+                }
+
+                spatial.position += translation * earliest.time;
+                ++world.continuous_impacts;
+
+                const f32 approach = glm::dot(body.velocity, earliest.normal);
+                if (approach > 0.0f)
+                {
+                    body.velocity -= approach * earliest.normal;
+                }
+                remaining_time *= 1.0f - earliest.time;
+                translation = body.velocity * remaining_time;
+            }
+        }
+    }
+
+    void update_continuous_bodies(entity_registry& registry, f32 delta_time)
+    {
+        auto& continuous_storage = registry.storage<continuous_collision_component>();
+        for (auto&& [entity, body, spatial] : get_awake_bodies(registry).each())
+        {
+            const shape_component* shape = registry.try_get<shape_component>(entity);
+            if (shape == nullptr)
+            {
+                continue;
+            }
+
+            const f32 reach = get_inner_radius(*shape);
+            const bool fast = glm::dot(body.velocity, body.velocity) * delta_time * delta_time > reach * reach;
+            if (!continuous_storage.contains(entity))
+            {
+                if (fast)
+                {
+                    continuous_storage.emplace(entity).automatic = true;
+                }
+            }
+            else if (!fast && continuous_storage.get(entity).automatic)
+            {
+                continuous_storage.erase(entity);
+            }
+        }
     }
-}
\ No newline at end of file
+}
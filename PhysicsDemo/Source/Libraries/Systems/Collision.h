@@ -1,7 +1,135 @@
 #pragma once
 
 #include "Entity.h"
+#include "Broadphase.h"
+#include "PairCache.h"
+#include "ContactSolver.h"
+#include "XpbdSolver.h"
+#include "FilteredTree.h"
+#include "Math/Contact.h"
+#include "Math/Gjk.h"
+#include "Math/SphereBatch.h"
+#include "Math/TimeOfImpact.h"
+
+#include <memory>
+
 namespace jm
 {
-    void resolve_collisions(entity_registry& registry);
-}
\ No newline at end of file
+    enum class broadphase_type
+    {
+        BruteForce,
+        UniformGrid,
+        SweepAndPrune,
+        DynamicTree
+    };
+
+    enum class solver_type
+    {
+        Impulse, //integrate, then sequential impulses on the contacts found at the end of the step
+        Xpbd //substepped position based dynamics, integration included
+    };
+
+    struct collision_settings
+    {
+        broadphase_type broadphase = broadphase_type::UniformGrid;
+        f32 grid_cell_size = 2.0f; //proxies larger than a cell fall back to brute force, so cover the common body size, and its motion under XPBD
+        u32 grid_thread_count = 0; //zero uses every hardware thread, small scenes stay on one regardless
+        f32 tree_margin = 0.1f; //how far a body may move before its tree leaf is reinserted
+        f32 contact_match_distance = 0.05f; //how far a contact point may drift and still inherit last update's impulses
+        bool ccd_fast_bodies = true; //simulate gives bodies about to move further than their inner radius in a step a continuous_collision_component
+        f32 ccd_motion_threshold = 0.5f; //continuous bodies moving less than this per step are left to the discrete test
+        f32 ccd_tolerance = 0.01f; //swept bodies stop this far short of what they hit
+        u32 ccd_max_substeps = 4; //impacts handled per body per step, the body stops at the last one
+        f32 sleep_velocity = 0.05f; //bodies slower than this, and turning slower in radians per second, count as resting
+        f32 sleep_time = 0.5f; //how long every body of an island must rest before the island sleeps, zero never sleeps
+        solver_type solver_mode = solver_type::Impulse;
+        contact_solver_settings solver;
+        xpbd_settings xpbd;
+    };
+
+    struct collision_world
+    {
+        explicit collision_world(collision_settings const& settings = {});
+
+        void set_broadphase(broadphase_type type);
+
+        //bakes every shape without a body into the static tree, call once the world has been created.
+        //Statics added afterwards are ignored until the next bake.
+        void bake_static_bodies(entity_registry const& registry);
+
+        collision_settings settings;
+        std::unique_ptr<worker_pool> workers; //threads the broadphase and the solver share, started once with the world
+        std::unique_ptr<broadphase> pair_finder; //only ever sees bodies, statics are queried from static_tree
+
+        filtered_aabb_tree static_tree;
+        broadphase_stats static_stats;
+
+        std::vector<collision_proxy> proxies;
+        std::vector<collision_pair> pairs;
+
+        std::vector<collision_pair> contacts; //pairs whose shapes touch this update
+        std::vector<math::contact_manifold3<f32>> manifolds; //one per contact, the solver accumulates impulses into these in place
+
+        //last update's manifolds and where each pair's one sits, so new points can pick up the impulses of the points they continue
+        std::vector<math::contact_manifold3<f32>> previous_manifolds;
+        collision_pair_map<u32> manifold_indices;
+        uSize warm_started_points = 0;
+        uSize continuous_impacts = 0;
+        //bodies where integrate left them, built only in updates where a continuous body moved far enough to be swept
+        filtered_aabb_tree body_tree;
+        collision_pair_map<math::gjk_cache<f32>> simplex_cache; //box-box pairs, GJK rules out separated ones before the separating axis test
+
+        //sphere-sphere pairs are gathered during the narrowphase and tested in one batch afterwards
+        std::vector<collision_pair> sphere_pairs;
+        math::sphere_pair_batch sphere_batch;
+        math::sphere_contact_batch sphere_contacts;
+
+        //sphere-box pairs as {box, sphere}, sorted so every box tests all of its spheres in one batch
+        std::vector<collision_pair> box_sphere_pairs;
+        std::vector<math::sphere3<f32>> box_spheres;
+        std::vector<math::contact_manifold3<f32>> box_sphere_manifolds;
+
+        //sleeping bodies are kept out of the broadphase in a tree of their own, rebuilt only when bodies fall asleep or wake
+        filtered_aabb_tree sleeping_tree;
+        bool sleeping_tree_dirty = false;
+        u32 next_sleeping_island = 0;
+        std::vector<f32> rest_times; //entity index to how long the body has been resting
+        std::vector<u32> waking_islands;
+        std::vector<entity_id> waking_entities;
+        uSize woken_bodies = 0;
+
+        collision_pair_cache contact_cache;
+        collision_events contact_events;
+        contact_solver solver;
+        xpbd_solver xpbd;
+    };
+
+    std::unique_ptr<broadphase> make_broadphase(collision_settings const& settings, worker_pool& workers);
+
+    //Finds this update's contacts, then solves them into body velocities for the next integrate, and with solver substeps
+    //into positions as well. Sleeping bodies touched by an awake one wake with the rest of their island, islands that have
+    //rested for settings.sleep_time go to sleep.
+    void resolve_collisions(entity_registry& registry, collision_world& world, f32 delta_time);
+
+    //Advances the world by delta_time with the pipeline settings.solver_mode selects. For Impulse that is integrate,
+    //resolve_continuous_collisions and resolve_collisions, for Xpbd it is step_xpbd. Either way store_previous_poses runs
+    //first so the update can be drawn interpolated. With settings.ccd_fast_bodies the Impulse pipeline first attaches continuous
+    //collision to the bodies that need it, see update_continuous_bodies.
+    void simulate(entity_registry& registry, collision_world& world, f32 delta_time);
+
+    //Integrates and resolves contacts in one go with the XPBD solver, finding candidate pairs from bounds swept by the step's
+    //motion. Sleeping bodies touched at the first substep wake with the rest of their island for the next update, islands
+    //that have rested go to sleep after the step, and fast bodies need no continuous pass since substeps are short. Contacts
+    //are reported as with resolve_collisions but there are no manifolds.
+    void step_xpbd(entity_registry& registry, collision_world& world, f32 delta_time);
+
+    //Sweeps every body with a continuous_collision_component from where integrate started it to where it ended up, against
+    //the baked statics and the other bodies at their end positions. On impact the body is moved to the time of impact, loses
+    //the velocity heading into the surface and slides for the rest of the step. Call between integrate and resolve_collisions.
+    //Other bodies are found through a tree over their bounds, built once for the update and only when a body is swept.
+    void resolve_continuous_collisions(entity_registry& registry, collision_world& world, f32 delta_time);
+
+    //Gives every awake body whose velocity would carry it further than its inner radius over delta_time a continuous
+    //collision component, and takes the ones it gave off bodies that have slowed down. Components attached by hand stay.
+    void update_continuous_bodies(entity_registry& registry, f32 delta_time);
+}
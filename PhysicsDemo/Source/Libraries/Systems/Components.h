@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Math/Physics.h"
+#include "Broadphase.h"
 
 namespace jm
 {
@@ -8,6 +9,12 @@ namespace jm
 
     using spatial3_component = math::rigid_motion3<f32>;
 
+    //the pose a body had before the last update, so it can be drawn between updates. Bodies without one are drawn where they are
+    struct previous_spatial3_component
+    {
+        spatial3_component pose{};
+    };
+
     enum class shape_component
     {
         Box,
@@ -16,4 +23,50 @@ namespace jm
 
     using linear_body2_component = math::linear_body2<f32>;
     using linear_body3_component = math::linear_body3<f32>;
+
+    //spin for a body that also has a linear_body3_component, bodies without one keep the orientation they were made with
+    using rotational_body3_component = math::rotational_body3<f32>;
+
+    //bodies and statics without one collide with everything
+    using collision_filter_component = collision_filter;
+
+    //opts a body into swept collision tests, integrate records where the body started the step
+    struct continuous_collision_component
+    {
+        math::vector3<f32> start_position{};
+        bool automatic = false; //attached by simulate to a fast body, which takes it off again once the body slows down
+    };
+
+    //a body whose island came to rest. It is skipped by integrate and the solver and left out of the broadphase until a contact
+    //wakes it, bodies that fell asleep together share an island so they wake together. Removing it wakes just the one body.
+    struct sleeping_component
+    {
+        u32 island = 0;
+    };
+
+    enum class joint_type
+    {
+        BallSocket, //anchors held together
+        Hinge, //anchors held together, turning only about the axis
+        Distance, //anchors held length apart
+        Fixed //anchors held together, no turning
+    };
+
+    //Joins body a to body b, or to the world when b is null, and lives on an entity of its own so a body can have any number
+    //of joints. Anchors are offsets from the body's position in its own frame, on the world the anchor is the point itself.
+    //Hinge and fixed joints hold b at relative_orientation in the frame of a, the world counting as unturned. The XPBD solver
+    //only moves positions, so there they hold the anchors like a ball socket.
+    struct joint_component
+    {
+        joint_type type = joint_type::BallSocket;
+        entity_id a = null_entity_id;
+        entity_id b = null_entity_id;
+        math::vector3<f32> local_anchor_a{};
+        math::vector3<f32> local_anchor_b{};
+        math::vector3<f32> local_axis{ 0.0f, 1.0f, 0.0f }; //hinge axis in the frame of a
+        math::quaternion<f32> relative_orientation{ 1.0f, 0.0f, 0.0f, 0.0f }; //conjugate(a) * b to hold the pose they start in
+        f32 length = 0.0f; //distance joints
+        math::vector3<f32> impulse{}; //accumulated along each row by the impulse solver, to warm start from
+        math::vector3<f32> angular_impulse{}; //the same for the rows holding the orientation
+    };
 }
\ No newline at end of file
@@ -0,0 +1,1083 @@
+#include "ContactSolver.h"
+#include "Components.h"
+#include "Shapes.h"
+#include "Simulation.h"
+#include "Workers.h"
+
+#include <algorithm>
+#include <barrier>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <immintrin.h>
+
+namespace jm
+{
+	namespace
+	{
+		template <typename T>
+		void gather(std::vector<T>& field, std::vector<T>& scratch, std::vector<u32> const& order)
+		{
+			scratch.resize(order.size());
+			for (uSize idx = 0; idx < order.size(); ++idx)
+			{
+				scratch[idx] = field[order[idx]];
+			}
+			field.swap(scratch);
+		}
+
+		__m128 load_lanes(std::vector<f32> const& field, u32 const* index)
+		{
+			return _mm_setr_ps(field[index[0]], field[index[1]], field[index[2]], field[index[3]]);
+		}
+
+		void store_lanes(std::vector<f32>& field, u32 const* index, __m128 values)
+		{
+			alignas(16) f32 lanes[4];
+			_mm_store_ps(lanes, values);
+			for (u32 lane = 0; lane < 4; ++lane)
+			{
+				field[index[lane]] = lanes[lane];
+			}
+		}
+
+		//Four rows side by side. A row and four rows take the same operations below, so solve_row_as is written once and a
+		//row gets the same impulse whichever path solves it. Wrapped since __m128 loses its alignment as a template argument.
+		struct lane4
+		{
+			__m128 value;
+		};
+
+		f32 lane_add(f32 a, f32 b) { return a + b; }
+		f32 lane_sub(f32 a, f32 b) { return a - b; }
+		f32 lane_mul(f32 a, f32 b) { return a * b; }
+		f32 lane_div(f32 a, f32 b) { return a / b; }
+		f32 lane_max(f32 a, f32 b) { return a > b ? a : b; } //b on ties, like maxps
+		f32 lane_sqrt(f32 a) { return std::sqrt(a); }
+		lane4 lane_add(lane4 a, lane4 b) { return { _mm_add_ps(a.value, b.value) }; }
+		lane4 lane_sub(lane4 a, lane4 b) { return { _mm_sub_ps(a.value, b.value) }; }
+		lane4 lane_mul(lane4 a, lane4 b) { return { _mm_mul_ps(a.value, b.value) }; }
+		lane4 lane_div(lane4 a, lane4 b) { return { _mm_div_ps(a.value, b.value) }; }
+		lane4 lane_max(lane4 a, lane4 b) { return { _mm_max_ps(a.value, b.value) }; }
+		lane4 lane_sqrt(lane4 a) { return { _mm_sqrt_ps(a.value) }; }
+		bool any_positive(f32 a) { return a > 0.0f; }
+		bool any_positive(lane4 a) { return _mm_movemask_ps(_mm_cmpgt_ps(a.value, _mm_setzero_ps())) != 0; }
+
+		template <typename Lane>
+		Lane splat(f32 value);
+		template <>
+		f32 splat<f32>(f32 value) { return value; }
+		template <>
+		lane4 splat<lane4>(f32 value) { return { _mm_set1_ps(value) }; }
+
+		//rows are contiguous from row, bodies are gathered through the rows' body indices
+		template <typename Lane>
+		Lane load_rows(std::vector<f32> const& field, u32 row);
+		template <>
+		f32 load_rows<f32>(std::vector<f32> const& field, u32 row) { return field[row]; }
+		template <>
+		lane4 load_rows<lane4>(std::vector<f32> const& field, u32 row) { return { _mm_loadu_ps(field.data() + row) }; }
+
+		void store_rows(std::vector<f32>& field, u32 row, f32 value) { field[row] = value; }
+		void store_rows(std::vector<f32>& field, u32 row, lane4 value) { _mm_storeu_ps(field.data() + row, value.value); }
+
+		template <typename Lane>
+		Lane load_bodies(std::vector<f32> const& field, u32 const* index);
+		template <>
+		f32 load_bodies<f32>(std::vector<f32> const& field, u32 const* index) { return field[*index]; }
+		template <>
+		lane4 load_bodies<lane4>(std::vector<f32> const& field, u32 const* index) { return { load_lanes(field, index) }; }
+
+		void store_bodies(std::vector<f32>& field, u32 const* index, f32 value) { field[*index] = value; }
+		void store_bodies(std::vector<f32>& field, u32 const* index, lane4 value) { store_lanes(field, index, value.value); }
+
+		//the small angle that turns from into to, the short way round
+		math::vector3<f32> get_rotation(math::quaternion<f32> const& from, math::quaternion<f32> const& to)
+		{
+			math::quaternion<f32> turn = to * glm::conjugate(from);
+			turn = turn.w < 0.0f ? -turn : turn;
+			const math::vector3<f32> axis{ turn.x, turn.y, turn.z };
+			const f32 sine = glm::length(axis);
+			return sine > math::epsilon<f32>() ? axis * (2.0f * std::atan2(sine, turn.w) / sine) : axis * 2.0f;
+		}
+	}
+
+	std::array<std::vector<f32>*, contact_solver::BodyFields> contact_solver::body_arrays::fields()
+	{
+		return { &velocity[0], &velocity[1], &velocity[2], &angular_velocity[0], &angular_velocity[1], &angular_velocity[2],
+			&delta[0], &delta[1], &delta[2], &rotation[0], &rotation[1], &rotation[2], &inverse_mass };
+	}
+
+	std::array<std::vector<f32>*, contact_solver::AxisFields> contact_solver::axis_arrays::fields()
+	{
+		return { &linear[0], &linear[1], &linear[2], &angular_a[0], &angular_a[1], &angular_a[2], &angular_b[0], &angular_b[1], &angular_b[2],
+			&response_a[0], &response_a[1], &response_a[2], &response_b[0], &response_b[1], &response_b[2], &effective_mass };
+	}
+
+	std::array<std::vector<f32>*, contact_solver::TurnFields> contact_solver::turn_arrays::fields()
+	{
+		return { &response_a[0], &response_a[1], &response_a[2], &response_b[0], &response_b[1], &response_b[2], &effective_mass };
+	}
+
+	std::array<std::vector<f32>*, contact_solver::RowFields> contact_solver::row_arrays::fields()
+	{
+		std::array<std::vector<f32>*, RowFields> result{};
+		uSize count = 0;
+		for (axis_arrays* axis : { &normal, &tangent, &bitangent })
+		{
+			for (std::vector<f32>* field : axis->fields())
+			{
+				result[count++] = field;
+			}
+		}
+		for (turn_arrays* turn : { &roll_tangent, &roll_bitangent })
+		{
+			for (std::vector<f32>* field : turn->fields())
+			{
+				result[count++] = field;
+			}
+		}
+		for (std::vector<f32>* field : { &bias, &impulse, &tangent_impulse, &bitangent_impulse, &friction, &rolling_resistance, &roll_tangent_impulse,
+			&roll_bitangent_impulse, &lower_impulse, &separation })
+		{
+			result[count++] = field;
+		}
+		return result;
+	}
+
+	u32 contact_solver::get_body(entity_registry& registry, entity_id entity)
+	{
+		linear_body3_component const* body = registry.try_get<linear_body3_component>(entity);
+		if (body == nullptr)
+		{
+			return StaticBody;
+		}
+
+		const uSize entity_index = static_cast<uSize>(entt::to_entity(entity));
+		if (entity_index >= entity_bodies.size())
+		{
+			entity_bodies.resize(entity_index + 1, InvalidBody);
+		}
+
+		u32& mapped_body = entity_bodies[entity_index];
+		if (mapped_body == InvalidBody)
+		{
+			//bodies without a rotational_body3_component have no inverse inertia, so rows leave them unturned
+			math::vector3<f32> angular_velocity{ 0.0f };
+			math::matrix33<f32> inverse_inertia{ 0.0f };
+			if (rotational_body3_component const* rotational = registry.try_get<rotational_body3_component>(entity))
+			{
+				angular_velocity = rotational->velocity;
+				inverse_inertia = rotational->world_inverse_inertia; //integrate worked it out this update
+			}
+
+			mapped_body = static_cast<u32>(body_entities.size());
+			body_entities.push_back(entity);
+			inverse_inertias.push_back(inverse_inertia);
+			for (u32 axis = 0; axis < 3; ++axis)
+			{
+				bodies.velocity[axis].push_back(body->velocity[axis]);
+				bodies.angular_velocity[axis].push_back(angular_velocity[axis]);
+				bodies.delta[axis].push_back(0.0f);
+				bodies.rotation[axis].push_back(0.0f);
+			}
+			bodies.inverse_mass.push_back(body->inverse_mass);
+		}
+		return mapped_body;
+	}
+
+	void contact_solver::set_axis(axis_arrays& axis, u32 row, jacobian const& jacobian)
+	{
+		const u32 body_a = rows.body_a[row];
+		const u32 body_b = rows.body_b[row];
+		const math::vector3<f32> response_a = inverse_inertias[body_a] * jacobian.angular_a;
+		const math::vector3<f32> response_b = inverse_inertias[body_b] * jacobian.angular_b;
+		for (u32 component = 0; component < 3; ++component)
+		{
+			axis.linear[component][row] = jacobian.linear[component];
+			axis.angular_a[component][row] = jacobian.angular_a[component];
+			axis.angular_b[component][row] = jacobian.angular_b[component];
+			axis.response_a[component][row] = response_a[component];
+			axis.response_b[component][row] = response_b[component];
+		}
+
+		//an axis neither body can move along, such as a turn against a static by a body that does not rotate, does nothing
+		const f32 inverse_mass = (bodies.inverse_mass[body_a] + bodies.inverse_mass[body_b]) * glm::dot(jacobian.linear, jacobian.linear)
+			+ glm::dot(jacobian.angular_a, response_a) + glm::dot(jacobian.angular_b, response_b);
+		axis.effective_mass[row] = inverse_mass > 0.0f ? 1.0f / inverse_mass : 0.0f;
+	}
+
+	void contact_solver::add_row(u32 body_a, u32 body_b, jacobian const& normal, f32 bias, f32 impulse, f32 separation, f32 lower_impulse, u32 manifold, u32 point)
+	{
+		const u32 row = static_cast<u32>(rows.impulse.size());
+		rows.body_a.push_back(body_a);
+		rows.body_b.push_back(body_b);
+		rows.manifold.push_back(manifold);
+		rows.point.push_back(point);
+		for (std::vector<f32>* field : rows.fields())
+		{
+			field->push_back(0.0f);
+		}
+		set_axis(rows.normal, row, normal);
+		rows.bias[row] = bias;
+		rows.impulse[row] = impulse;
+		rows.separation[row] = separation;
+		rows.lower_impulse[row] = lower_impulse;
+	}
+
+	void contact_solver::set_friction(u32 row, jacobian const& tangent, jacobian const& bitangent, math::vector2<f32> const& impulse, f32 friction)
+	{
+		set_axis(rows.tangent, row, tangent);
+		set_axis(rows.bitangent, row, bitangent);
+		rows.tangent_impulse[row] = impulse.x;
+		rows.bitangent_impulse[row] = impulse.y;
+		rows.friction[row] = friction;
+	}
+
+	void contact_solver::set_turn(turn_arrays& turn, u32 row, math::vector3<f32> const& axis)
+	{
+		const math::vector3<f32> response_a = inverse_inertias[rows.body_a[row]] * axis;
+		const math::vector3<f32> response_b = inverse_inertias[rows.body_b[row]] * axis;
+		for (u32 component = 0; component < 3; ++component)
+		{
+			turn.response_a[component][row] = response_a[component];
+			turn.response_b[component][row] = response_b[component];
+		}
+		const f32 inverse_mass = glm::dot(axis, response_a) + glm::dot(axis, response_b);
+		turn.effective_mass[row] = inverse_mass > 0.0f ? 1.0f / inverse_mass : 0.0f;
+	}
+
+	void contact_solver::set_rolling(u32 row, math::vector2<f32> const& impulse, f32 rolling_resistance)
+	{
+		set_turn(rows.roll_tangent, row, { rows.tangent.linear[0][row], rows.tangent.linear[1][row], rows.tangent.linear[2][row] });
+		set_turn(rows.roll_bitangent, row, { rows.bitangent.linear[0][row], rows.bitangent.linear[1][row], rows.bitangent.linear[2][row] });
+		rows.roll_tangent_impulse[row] = impulse.x;
+		rows.roll_bitangent_impulse[row] = impulse.y;
+		rows.rolling_resistance[row] = rows.roll_tangent.effective_mass[row] > 0.0f ? rolling_resistance : 0.0f; //neither body turns
+	}
+
+	void contact_solver::build_rows(entity_registry& registry, std::vector<collision_pair> const& contacts, std::vector<math::contact_manifold3<f32>> const& manifolds,
+		contact_solver_settings const& settings, f32 delta_time)
+	{
+		body_entities.assign(1, null_entity_id);
+		inverse_inertias.assign(1, math::matrix33<f32>{ 0.0f });
+		for (std::vector<f32>* field : bodies.fields())
+		{
+			field->assign(1, 0.0f);
+		}
+
+		for (std::vector<u32>* field : { &rows.body_a, &rows.body_b, &rows.manifold, &rows.point })
+		{
+			field->clear();
+		}
+		for (std::vector<f32>* field : rows.fields())
+		{
+			field->clear();
+		}
+
+		//a direction acting at a point, turning each body about its centre through its lever arm to the point
+		const auto at_point = [](math::vector3<f32> const& direction, math::vector3<f32> const& arm_a, math::vector3<f32> const& arm_b)
+			{
+				return jacobian{ direction, cross(arm_a, direction), cross(arm_b, direction) };
+			};
+
+		//a sphere rolls on whatever it touches, about the larger radius when two do
+		const auto rolling_radius = [&registry](entity_id entity)
+			{
+				shape_component const* shape = registry.try_get<shape_component>(entity);
+				return shape != nullptr && *shape == shape_component::Sphere ? get_inner_radius(*shape) : 0.0f;
+			};
+
+		const f32 bias_rate = delta_time > 0.0f ? settings.baumgarte / delta_time : 0.0f;
+		for (uSize idx = 0; idx < contacts.size(); ++idx)
+		{
+			const u32 body_a = get_body(registry, contacts[idx].a);
+			const u32 body_b = get_body(registry, contacts[idx].b);
+			const f32 inverse_mass = bodies.inverse_mass[body_a] + bodies.inverse_mass[body_b];
+			if (inverse_mass <= 0.0f)
+			{
+				continue;
+			}
+
+			//points keep the tangent basis warm starting carried over, new ones take the one picked for the normal
+			math::contact_manifold3<f32> const& manifold = manifolds[idx];
+			const math::vector3<f32> fresh_tangent = math::any_tangent(manifold.normal);
+			const math::vector3<f32> position_a = registry.get<spatial3_component>(contacts[idx].a).position;
+			const math::vector3<f32> position_b = registry.get<spatial3_component>(contacts[idx].b).position;
+			const f32 rolling_resistance = settings.rolling_resistance * std::max(rolling_radius(contacts[idx].a), rolling_radius(contacts[idx].b));
+			for (u32 point = 0; point < manifold.point_count; ++point)
+			{
+				math::contact_point3<f32> const& contact = manifold.points[point];
+				const math::vector3<f32> arm_a = contact.position - position_a;
+				const math::vector3<f32> arm_b = contact.position - position_b;
+				const math::vector3<f32> tangent = contact.tangent == math::vector3<f32>{} ? fresh_tangent : contact.tangent;
+				const u32 row = static_cast<u32>(rows.impulse.size());
+				add_row(body_a, body_b, at_point(manifold.normal, arm_a, arm_b), bias_rate * std::max(contact.depth - settings.penetration_slop, 0.0f), contact.normal_impulse,
+					-contact.depth, 0.0f, static_cast<u32>(idx), point);
+				set_friction(row, at_point(tangent, arm_a, arm_b), at_point(cross(manifold.normal, tangent), arm_a, arm_b), contact.tangent_impulse, settings.friction);
+				if (rolling_resistance > 0.0f)
+				{
+					set_rolling(row, contact.rolling_impulse, rolling_resistance);
+				}
+			}
+		}
+
+		//Joints between bodies that are both asleep or static are left out, a sleeping body joined to an awake one has been woken
+		//by now. The anchors' offset is the error, held to zero along each axis or to the length along the line between them.
+		//Hinge and fixed joints add rows that only turn, the error being how far b has turned from where a holds it.
+		const u32 contact_rows = static_cast<u32>(rows.impulse.size());
+		auto& sleeping_storage = registry.storage<sleeping_component>();
+		joint_entities.clear();
+		for (auto&& [entity, joint] : registry.view<const joint_component>().each())
+		{
+			if (!registry.valid(joint.a) || (joint.b != null_entity_id && !registry.valid(joint.b))
+				|| sleeping_storage.contains(joint.a) || (joint.b != null_entity_id && sleeping_storage.contains(joint.b)))
+			{
+				continue;
+			}
+
+			const u32 body_a = get_body(registry, joint.a);
+			const u32 body_b = joint.b == null_entity_id ? StaticBody : get_body(registry, joint.b);
+			if (bodies.inverse_mass[body_a] + bodies.inverse_mass[body_b] <= 0.0f)
+			{
+				continue;
+			}
+
+			const u32 joint_index = static_cast<u32>(contacts.size() + joint_entities.size());
+			joint_entities.push_back(entity);
+			const math::vector3<f32> anchor_a = get_joint_anchor(registry, joint.a, joint.local_anchor_a);
+			const math::vector3<f32> anchor_b = get_joint_anchor(registry, joint.b, joint.local_anchor_b);
+			const math::vector3<f32> arm_a = anchor_a - registry.get<spatial3_component>(joint.a).position;
+			const math::vector3<f32> arm_b = joint.b == null_entity_id ? math::zero3 : anchor_b - registry.get<spatial3_component>(joint.b).position;
+			const math::vector3<f32> offset = anchor_b - anchor_a;
+			if (joint.type == joint_type::Distance)
+			{
+				const f32 distance = glm::length(offset);
+				const math::vector3<f32> normal = distance > math::epsilon<f32>() ? offset / distance : math::vector3<f32>{ 0.0f, 1.0f, 0.0f };
+				const f32 error = distance - joint.length;
+				add_row(body_a, body_b, at_point(normal, arm_a, arm_b), -bias_rate * error, joint.impulse.x, error, -std::numeric_limits<f32>::max(), joint_index, 0);
+				continue;
+			}
+
+			for (u32 axis = 0; axis < 3; ++axis)
+			{
+				math::vector3<f32> normal{ 0.0f };
+				normal[axis] = 1.0f;
+				add_row(body_a, body_b, at_point(normal, arm_a, arm_b), -bias_rate * offset[axis], joint.impulse[axis], offset[axis], -std::numeric_limits<f32>::max(), joint_index, axis);
+			}
+			if (joint.type == joint_type::BallSocket)
+			{
+				continue;
+			}
+
+			//a fixed joint holds all three world axes, a hinge the two across its axis, where the error is the turn taking a's
+			//hinge axis to b's
+			const math::quaternion<f32> orientation_a = registry.get<spatial3_component>(joint.a).orientation;
+			const math::quaternion<f32> orientation_b = joint.b == null_entity_id ? math::quaternion<f32>{ 1.0f, 0.0f, 0.0f, 0.0f } : registry.get<spatial3_component>(joint.b).orientation;
+			math::vector3<f32> error = get_rotation(orientation_a * joint.relative_orientation, orientation_b);
+			std::array<math::vector3<f32>, 3> axes = { math::vector3<f32>{ 1.0f, 0.0f, 0.0f }, math::vector3<f32>{ 0.0f, 1.0f, 0.0f }, math::vector3<f32>{ 0.0f, 0.0f, 1.0f } };
+			u32 axis_count = 3;
+			if (joint.type == joint_type::Hinge)
+			{
+				const math::vector3<f32> hinge_a = orientation_a * joint.local_axis;
+				const math::vector3<f32> hinge_b = orientation_b * (glm::conjugate(joint.relative_orientation) * joint.local_axis);
+				error = cross(hinge_a, hinge_b);
+				axes[0] = math::any_tangent(hinge_a);
+				axes[1] = cross(hinge_a, axes[0]);
+				axis_count = 2;
+			}
+			for (u32 axis = 0; axis < axis_count; ++axis)
+			{
+				const f32 angle = glm::dot(error, axes[axis]);
+				add_row(body_a, body_b, jacobian{ math::zero3, axes[axis], axes[axis] }, -bias_rate * angle, joint.angular_impulse[axis], angle,
+					-std::numeric_limits<f32>::max(), joint_index, 3 + axis);
+			}
+		}
+		joint_row_count = rows.impulse.size() - contact_rows;
+	}
+
+	void contact_solver::apply_axis(axis_arrays const& axis, u32 row, f32 impulse)
+	{
+		const u32 a = rows.body_a[row];
+		const u32 b = rows.body_b[row];
+		const f32 impulse_a = impulse * bodies.inverse_mass[a];
+		const f32 impulse_b = impulse * bodies.inverse_mass[b];
+		for (u32 component = 0; component < 3; ++component)
+		{
+			bodies.velocity[component][a] -= axis.linear[component][row] * impulse_a;
+			bodies.velocity[component][b] += axis.linear[component][row] * impulse_b;
+			bodies.angular_velocity[component][a] -= axis.response_a[component][row] * impulse;
+			bodies.angular_velocity[component][b] += axis.response_b[component][row] * impulse;
+		}
+	}
+
+	void contact_solver::apply_turn(turn_arrays const& turn, u32 row, f32 impulse)
+	{
+		const u32 a = rows.body_a[row];
+		const u32 b = rows.body_b[row];
+		for (u32 component = 0; component < 3; ++component)
+		{
+			bodies.angular_velocity[component][a] -= turn.response_a[component][row] * impulse;
+			bodies.angular_velocity[component][b] += turn.response_b[component][row] * impulse;
+		}
+	}
+
+	void contact_solver::apply_impulse(u32 row)
+	{
+		apply_axis(rows.normal, row, rows.impulse[row]);
+		apply_axis(rows.tangent, row, rows.tangent_impulse[row]);
+		apply_axis(rows.bitangent, row, rows.bitangent_impulse[row]);
+		if (rows.rolling_resistance[row] > 0.0f)
+		{
+			apply_turn(rows.roll_tangent, row, rows.roll_tangent_impulse[row]);
+			apply_turn(rows.roll_bitangent, row, rows.roll_bitangent_impulse[row]);
+		}
+	}
+
+	void contact_solver::permute_rows()
+	{
+		gather(rows.body_a, sorted_rows.body_a, row_order);
+		gather(rows.body_b, sorted_rows.body_b, row_order);
+		gather(rows.manifold, sorted_rows.manifold, row_order);
+		gather(rows.point, sorted_rows.point, row_order);
+		const std::array<std::vector<f32>*, RowFields> fields = rows.fields();
+		const std::array<std::vector<f32>*, RowFields> scratch = sorted_rows.fields();
+		for (uSize field = 0; field < RowFields; ++field)
+		{
+			gather(*fields[field], *scratch[field], row_order);
+		}
+	}
+
+	void contact_solver::build_islands(u32 worker_count, bool color_large_islands)
+	{
+		const u32 body_count = static_cast<u32>(body_entities.size());
+		const u32 row_count = static_cast<u32>(rows.impulse.size());
+		dynamic_body_count = body_count - 1;
+
+		//link bodies through every row, statics are left out so a shared floor does not merge everything into one island
+		body_sets.reset(body_count);
+		pool->run(worker_count, [this, row_count, worker_count](u32 worker)
+			{
+				const u32 end = static_cast<u32>(chunk_begin(row_count, worker + 1, worker_count));
+				for (u32 row = static_cast<u32>(chunk_begin(row_count, worker, worker_count)); row < end; ++row)
+				{
+					const u32 a = rows.body_a[row];
+					const u32 b = rows.body_b[row];
+					if (a != StaticBody && b != StaticBody)
+					{
+						body_sets.unite(a, b);
+					}
+				}
+			});
+
+		//roots are the smallest body of their island, so numbering in body order labels every root before its members
+		body_islands.assign(body_count, InvalidBody);
+		island_body_offsets.assign(1, 0);
+		for (u32 body = 1; body < body_count; ++body)
+		{
+			const u32 root = body_sets.find(body);
+			if (root == body)
+			{
+				body_islands[body] = static_cast<u32>(island_body_offsets.size() - 1);
+				island_body_offsets.push_back(0);
+			}
+			else
+			{
+				body_islands[body] = body_islands[root];
+			}
+			++island_body_offsets[body_islands[body] + 1];
+		}
+
+		//every row has at least one dynamic body to take the island from
+		const auto row_island = [this](u32 row)
+			{
+				const u32 a = rows.body_a[row];
+				return body_islands[a != StaticBody ? a : rows.body_b[row]];
+			};
+
+		const u32 island_count = static_cast<u32>(island_body_offsets.size() - 1);
+		island_row_offsets.assign(island_count + 1, 0);
+		for (u32 row = 0; row < row_count; ++row)
+		{
+			++island_row_offsets[row_island(row) + 1];
+		}
+
+		//islands big enough to colour go last, so the others can be handed out to tasks as one run
+		colored_island_begin = island_count;
+		if (color_large_islands)
+		{
+			island_order.resize(island_count);
+			u32 next_island = 0;
+			for (u32 island = 0; island < island_count; ++island)
+			{
+				if (island_row_offsets[island + 1] < MinColoredRows)
+				{
+					island_order[island] = next_island++;
+				}
+			}
+			colored_island_begin = next_island;
+			for (u32 island = 0; island < island_count; ++island)
+			{
+				if (island_row_offsets[island + 1] >= MinColoredRows)
+				{
+					island_order[island] = next_island++;
+				}
+			}
+
+			if (colored_island_begin != island_count)
+			{
+				for (u32 body = 1; body < body_count; ++body)
+				{
+					body_islands[body] = island_order[body_islands[body]];
+				}
+				for (std::vector<u32>* offsets : { &island_body_offsets, &island_row_offsets })
+				{
+					island_scratch = *offsets;
+					for (u32 island = 0; island < island_count; ++island)
+					{
+						(*offsets)[island_order[island] + 1] = island_scratch[island + 1];
+					}
+				}
+			}
+		}
+
+		stats = {};
+		stats.island_count = island_count;
+		for (u32 island = 0; island < island_count; ++island)
+		{
+			const uSize size = island_body_offsets[island + 1];
+			stats.largest_island = std::max(stats.largest_island, size);
+			++stats.size_histogram[std::min<uSize>(std::bit_width(size) - 1, island_stats::HistogramBuckets - 1)];
+			island_body_offsets[island + 1] += island_body_offsets[island];
+			island_row_offsets[island + 1] += island_row_offsets[island];
+		}
+
+		island_entities.resize(dynamic_body_count);
+		island_bodies.resize(dynamic_body_count);
+		island_velocities.resize(dynamic_body_count);
+		{
+			std::vector<u32> cursors(island_body_offsets.begin(), island_body_offsets.end() - 1);
+			for (u32 body = 1; body < body_count; ++body)
+			{
+				const u32 slot = cursors[body_islands[body]]++;
+				island_entities[slot] = body_entities[body];
+				island_bodies[slot] = body;
+			}
+		}
+
+		//stable counting sort of the rows by island
+		row_order.resize(row_count);
+		{
+			std::vector<u32> cursors(island_row_offsets.begin(), island_row_offsets.end() - 1);
+			for (u32 row = 0; row < row_count; ++row)
+			{
+				row_order[cursors[row_island(row)]++] = row;
+			}
+		}
+		permute_rows();
+
+		//each island gets a static body of its own after the dynamic ones, so no two tasks write the same body
+		for (std::vector<f32>* field : bodies.fields())
+		{
+			field->resize(body_count + island_count, 0.0f);
+		}
+		for (u32 island = 0; island < island_count; ++island)
+		{
+			for (u32 row = island_row_offsets[island]; row < island_row_offsets[island + 1]; ++row)
+			{
+				u32& a = rows.body_a[row];
+				u32& b = rows.body_b[row];
+				a = a == StaticBody ? body_count + island : a;
+				b = b == StaticBody ? body_count + island : b;
+			}
+		}
+	}
+
+	void contact_solver::build_colors()
+	{
+		const u32 begin = island_row_offsets[colored_island_begin];
+		const u32 row_count = static_cast<u32>(rows.impulse.size());
+		const u32 first_static_slot = static_cast<u32>(dynamic_body_count + 1);
+
+		//rows of one colour may still share an island's static, so every coloured row against a static gets a slot of its own
+		for (u32 row = begin; row < row_count; ++row)
+		{
+			for (u32* body : { &rows.body_a[row], &rows.body_b[row] })
+			{
+				if (*body >= first_static_slot)
+				{
+					*body = static_cast<u32>(bodies.inverse_mass.size());
+					for (std::vector<f32>* field : bodies.fields())
+					{
+						field->push_back(0.0f);
+					}
+				}
+			}
+		}
+
+		//greedy colouring in row order, each body remembers the colours of its rows. A row whose bodies have used every colour
+		//between them lands in the overflow colour, which is solved in order on one worker.
+		body_colors.assign(bodies.inverse_mass.size() * ColorWords, 0);
+		row_colors.resize(row_count - begin);
+		color_offsets.assign(OverflowColor + 2, 0);
+		for (u32 row = begin; row < row_count; ++row)
+		{
+			u64* colors_a = body_colors.data() + rows.body_a[row] * ColorWords;
+			u64* colors_b = body_colors.data() + rows.body_b[row] * ColorWords;
+			u32 color = OverflowColor;
+			for (u32 word = 0; word < ColorWords; ++word)
+			{
+				const u64 used = colors_a[word] | colors_b[word];
+				if (used != ~u64(0))
+				{
+					color = word * 64 + static_cast<u32>(std::countr_one(used));
+					colors_a[word] |= u64(1) << (color % 64);
+					colors_b[word] |= u64(1) << (color % 64);
+					break;
+				}
+			}
+			row_colors[row - begin] = color;
+			++color_offsets[color + 1];
+		}
+
+		color_count = 0;
+		for (u32 color = 0; color <= OverflowColor; ++color)
+		{
+			color_count += color_offsets[color + 1] > 0 ? 1 : 0;
+			color_offsets[color + 1] += color_offsets[color];
+		}
+
+		//the uncoloured rows keep their place, the coloured ones are sorted by colour
+		std::vector<u32> cursors(color_offsets.begin(), color_offsets.end() - 1);
+		for (u32 row = 0; row < begin; ++row)
+		{
+			row_order[row] = row;
+		}
+		for (u32 row = begin; row < row_count; ++row)
+		{
+			row_order[begin + cursors[row_colors[row - begin]]++] = row;
+		}
+		permute_rows();
+	}
+
+	template <typename Lane>
+	void contact_solver::solve_row_as(u32 row)
+	{
+		u32 const* a = rows.body_a.data() + row;
+		u32 const* b = rows.body_b.data() + row;
+		const Lane inverse_mass_a = load_bodies<Lane>(bodies.inverse_mass, a);
+		const Lane inverse_mass_b = load_bodies<Lane>(bodies.inverse_mass, b);
+		Lane velocity_a[3], velocity_b[3], angular_velocity_a[3], angular_velocity_b[3];
+		for (u32 component = 0; component < 3; ++component)
+		{
+			velocity_a[component] = load_bodies<Lane>(bodies.velocity[component], a);
+			velocity_b[component] = load_bodies<Lane>(bodies.velocity[component], b);
+			angular_velocity_a[component] = load_bodies<Lane>(bodies.angular_velocity[component], a);
+			angular_velocity_b[component] = load_bodies<Lane>(bodies.angular_velocity[component], b);
+		}
+
+		//velocity of b's point less a's along an axis
+		const auto relative_along = [&](axis_arrays const& axis)
+			{
+				Lane linear = splat<Lane>(0.0f);
+				Lane angular = splat<Lane>(0.0f);
+				for (u32 component = 0; component < 3; ++component)
+				{
+					linear = lane_add(linear, lane_mul(lane_sub(velocity_b[component], velocity_a[component]), load_rows<Lane>(axis.linear[component], row)));
+					angular = lane_add(angular, lane_sub(lane_mul(angular_velocity_b[component], load_rows<Lane>(axis.angular_b[component], row)),
+						lane_mul(angular_velocity_a[component], load_rows<Lane>(axis.angular_a[component], row))));
+				}
+				return lane_add(linear, angular);
+			};
+		const auto apply = [&](axis_arrays const& axis, Lane impulse)
+			{
+				const Lane impulse_a = lane_mul(impulse, inverse_mass_a);
+				const Lane impulse_b = lane_mul(impulse, inverse_mass_b);
+				for (u32 component = 0; component < 3; ++component)
+				{
+					const Lane direction = load_rows<Lane>(axis.linear[component], row);
+					velocity_a[component] = lane_sub(velocity_a[component], lane_mul(direction, impulse_a));
+					velocity_b[component] = lane_add(velocity_b[component], lane_mul(direction, impulse_b));
+					angular_velocity_a[component] = lane_sub(angular_velocity_a[component], lane_mul(load_rows<Lane>(axis.response_a[component], row), impulse));
+					angular_velocity_b[component] = lane_add(angular_velocity_b[component], lane_mul(load_rows<Lane>(axis.response_b[component], row), impulse));
+				}
+			};
+
+		//Friction first, against the normal impulse so far. The pair is scaled back onto the cone rather than clamped per
+		//tangent, so the friction is the same whichever way the contact slides.
+		const Lane previous_tangent = load_rows<Lane>(rows.tangent_impulse, row);
+		const Lane previous_bitangent = load_rows<Lane>(rows.bitangent_impulse, row);
+		const Lane tangent = lane_sub(previous_tangent, lane_mul(load_rows<Lane>(rows.tangent.effective_mass, row), relative_along(rows.tangent)));
+		const Lane bitangent = lane_sub(previous_bitangent, lane_mul(load_rows<Lane>(rows.bitangent.effective_mass, row), relative_along(rows.bitangent)));
+		const Lane max_friction = lane_mul(load_rows<Lane>(rows.friction, row), load_rows<Lane>(rows.impulse, row));
+		const Lane length = lane_sqrt(lane_add(lane_mul(tangent, tangent), lane_mul(bitangent, bitangent)));
+		const Lane scale = lane_div(max_friction, lane_max(lane_max(length, max_friction), splat<Lane>(std::numeric_limits<f32>::min())));
+		const Lane tangent_impulse = lane_mul(tangent, scale);
+		const Lane bitangent_impulse = lane_mul(bitangent, scale);
+		store_rows(rows.tangent_impulse, row, tangent_impulse);
+		store_rows(rows.bitangent_impulse, row, bitangent_impulse);
+		apply(rows.tangent, lane_sub(tangent_impulse, previous_tangent));
+		apply(rows.bitangent, lane_sub(bitangent_impulse, previous_bitangent));
+
+		//Rolling resistance the same way, b's turn less a's about the tangents. Most rows have none, so it is skipped unless one
+		//of them does.
+		if (any_positive(load_rows<Lane>(rows.rolling_resistance, row)))
+		{
+			const auto turn_along = [&](axis_arrays const& direction)
+				{
+					Lane turn = splat<Lane>(0.0f);
+					for (u32 component = 0; component < 3; ++component)
+					{
+						turn = lane_add(turn, lane_mul(lane_sub(angular_velocity_b[component], angular_velocity_a[component]), load_rows<Lane>(direction.linear[component], row)));
+					}
+					return turn;
+				};
+			const auto apply_turn = [&](turn_arrays const& turn, Lane impulse)
+				{
+					for (u32 component = 0; component < 3; ++component)
+					{
+						angular_velocity_a[component] = lane_sub(angular_velocity_a[component], lane_mul(load_rows<Lane>(turn.response_a[component], row), impulse));
+						angular_velocity_b[component] = lane_add(angular_velocity_b[component], lane_mul(load_rows<Lane>(turn.response_b[component], row), impulse));
+					}
+				};
+			const Lane previous_roll_tangent = load_rows<Lane>(rows.roll_tangent_impulse, row);
+			const Lane previous_roll_bitangent = load_rows<Lane>(rows.roll_bitangent_impulse, row);
+			const Lane roll_tangent = lane_sub(previous_roll_tangent, lane_mul(load_rows<Lane>(rows.roll_tangent.effective_mass, row), turn_along(rows.tangent)));
+			const Lane roll_bitangent = lane_sub(previous_roll_bitangent, lane_mul(load_rows<Lane>(rows.roll_bitangent.effective_mass, row), turn_along(rows.bitangent)));
+			const Lane max_roll = lane_mul(load_rows<Lane>(rows.rolling_resistance, row), load_rows<Lane>(rows.impulse, row));
+			const Lane roll_length = lane_sqrt(lane_add(lane_mul(roll_tangent, roll_tangent), lane_mul(roll_bitangent, roll_bitangent)));
+			const Lane roll_scale = lane_div(max_roll, lane_max(lane_max(roll_length, max_roll), splat<Lane>(std::numeric_limits<f32>::min())));
+			const Lane roll_tangent_impulse = lane_mul(roll_tangent, roll_scale);
+			const Lane roll_bitangent_impulse = lane_mul(roll_bitangent, roll_scale);
+			store_rows(rows.roll_tangent_impulse, row, roll_tangent_impulse);
+			store_rows(rows.roll_bitangent_impulse, row, roll_bitangent_impulse);
+			apply_turn(rows.roll_tangent, lane_sub(roll_tangent_impulse, previous_roll_tangent));
+			apply_turn(rows.roll_bitangent, lane_sub(roll_bitangent_impulse, previous_roll_bitangent));
+		}
+
+		//clamp the accumulated impulse rather than the increment so earlier overshoot can be taken back
+		const Lane previous = load_rows<Lane>(rows.impulse, row);
+		const Lane unclamped = lane_add(previous, lane_mul(load_rows<Lane>(rows.normal.effective_mass, row), lane_sub(load_rows<Lane>(rows.bias, row), relative_along(rows.normal))));
+		const Lane impulse = lane_max(load_rows<Lane>(rows.lower_impulse, row), unclamped);
+		store_rows(rows.impulse, row, impulse);
+		apply(rows.normal, lane_sub(impulse, previous));
+
+		for (u32 component = 0; component < 3; ++component)
+		{
+			store_bodies(bodies.velocity[component], a, velocity_a[component]);
+			store_bodies(bodies.velocity[component], b, velocity_b[component]);
+			store_bodies(bodies.angular_velocity[component], a, angular_velocity_a[component]);
+			store_bodies(bodies.angular_velocity[component], b, angular_velocity_b[component]);
+		}
+	}
+
+	void contact_solver::solve_row(u32 row)
+	{
+		solve_row_as<f32>(row);
+	}
+
+	void contact_solver::solve_row_lanes(u32 row)
+	{
+		solve_row_as<lane4>(row);
+	}
+
+	void contact_solver::solve_rows(u32 begin, u32 end, u32 iterations)
+	{
+		//warm start from the impulses carried over from the last update
+		for (u32 row = begin; row < end; ++row)
+		{
+			apply_impulse(row);
+		}
+
+		//the row update is branch free over flat arrays, the order still matters since rows sharing a body see each other's impulses
+		for (u32 iteration = 0; iteration < iterations; ++iteration)
+		{
+			for (u32 row = begin; row < end; ++row)
+			{
+				solve_row(row);
+			}
+		}
+	}
+
+	void contact_solver::warm_start_substeps(u32 begin, u32 end)
+	{
+		//A joint's impulse from the last update also holds what its bias pulled back, which the positions already carry, so
+		//feeding it in again makes a stiff chain ring up. Joints start from rest, contacts keep their warm start. Warm started,
+		//the long coloured chains of the joints benchmark stretched to 8.5 where starting from rest holds them to 0.04.
+		for (u32 row = begin; row < end; ++row)
+		{
+			if (rows.lower_impulse[row] < 0.0f)
+			{
+				rows.impulse[row] = 0.0f;
+			}
+			apply_impulse(row);
+		}
+	}
+
+	void contact_solver::refresh_bias(u32 begin, u32 end, f32 push_rate, f32 approach_rate, f32 penetration_slop)
+	{
+		//Contacts already apart may close the gap within the substep, so they are speculative and push only once they would
+		//overlap. Overlapping contacts push out a fraction of the depth beyond the slop and joints pull back a fraction of their
+		//error either way, none in the relaxation pass.
+		for (u32 row = begin; row < end; ++row)
+		{
+			const u32 a = rows.body_a[row];
+			const u32 b = rows.body_b[row];
+			f32 separation = rows.separation[row];
+			for (u32 component = 0; component < 3; ++component)
+			{
+				separation += (bodies.delta[component][b] - bodies.delta[component][a]) * rows.normal.linear[component][row]
+					+ bodies.rotation[component][b] * rows.normal.angular_b[component][row] - bodies.rotation[component][a] * rows.normal.angular_a[component][row];
+			}
+			rows.bias[row] = rows.lower_impulse[row] < 0.0f ? -push_rate * separation
+				: separation > 0.0f ? -approach_rate * separation : push_rate * std::max(-separation - penetration_slop, 0.0f);
+		}
+	}
+
+	void contact_solver::integrate_positions(u32 begin, u32 end, f32 substep_time)
+	{
+		for (u32 idx = begin; idx < end; ++idx)
+		{
+			const u32 body = island_bodies[idx];
+			for (u32 component = 0; component < 3; ++component)
+			{
+				bodies.delta[component][body] += bodies.velocity[component][body] * substep_time;
+				bodies.rotation[component][body] += bodies.angular_velocity[component][body] * substep_time;
+			}
+		}
+	}
+
+	void contact_solver::solve_substeps(u32 island_begin, u32 island_end, contact_solver_settings const& settings, f32 delta_time)
+	{
+		const u32 row_begin = island_row_offsets[island_begin];
+		const u32 row_end = island_row_offsets[island_end];
+		const u32 body_begin = island_body_offsets[island_begin];
+		const u32 body_end = island_body_offsets[island_end];
+		const f32 substep_time = delta_time / static_cast<f32>(settings.substeps);
+		const f32 inverse_substep_time = 1.0f / substep_time;
+
+		warm_start_substeps(row_begin, row_end);
+		for (u32 substep = 0; substep < settings.substeps; ++substep)
+		{
+			refresh_bias(row_begin, row_end, settings.baumgarte * inverse_substep_time, inverse_substep_time, settings.penetration_slop);
+			for (u32 row = row_begin; row < row_end; ++row)
+			{
+				solve_row(row);
+			}
+			integrate_positions(body_begin, body_end, substep_time);
+		}
+
+		//relax, gaps left open may close over the next step
+		refresh_bias(row_begin, row_end, 0.0f, 1.0f / delta_time, settings.penetration_slop);
+		for (u32 row = row_begin; row < row_end; ++row)
+		{
+			solve_row(row);
+		}
+	}
+
+	void contact_solver::solve_colors(u32 worker_count, contact_solver_settings const& settings, f32 delta_time)
+	{
+		const u32 begin = island_row_offsets[colored_island_begin];
+		const u32 row_count = static_cast<u32>(rows.impulse.size()) - begin;
+		const u32 body_begin = island_body_offsets[colored_island_begin];
+		const u32 body_count = island_body_offsets.back() - body_begin;
+
+		//Every worker walks the colours in the same order and waits for the others at the end of each one. Splits fall on
+		//whole lanes from the start of the colour, so which rows go through solve_row_lanes does not depend on worker_count.
+		std::barrier colors_done(static_cast<std::ptrdiff_t>(worker_count));
+		pool->run(worker_count, [&](u32 worker)
+			{
+				const auto sweep_colors = [&](bool warm_start)
+					{
+						for (u32 color = 0; color <= OverflowColor; ++color)
+						{
+							const u32 color_begin = begin + color_offsets[color];
+							const u32 color_end = begin + color_offsets[color + 1];
+							if (color_begin == color_end)
+							{
+								continue;
+							}
+
+							u32 chunk_start = color_begin;
+							u32 chunk_end = worker == 0 ? color_end : color_begin;
+							if (color != OverflowColor)
+							{
+								const uSize size = color_end - color_begin;
+								chunk_start = color_begin + static_cast<u32>(chunk_begin(size, worker, worker_count) & ~uSize(Lanes - 1));
+								chunk_end = worker + 1 == worker_count ? color_end : color_begin + static_cast<u32>(chunk_begin(size, worker + 1, worker_count) & ~uSize(Lanes - 1));
+							}
+
+							if (warm_start && settings.substeps > 0)
+							{
+								warm_start_substeps(chunk_start, chunk_end);
+							}
+							else if (warm_start)
+							{
+								for (u32 row = chunk_start; row < chunk_end; ++row)
+								{
+									apply_impulse(row);
+								}
+							}
+							else
+							{
+								u32 row = chunk_start;
+								if (color != OverflowColor)
+								{
+									for (; row + Lanes <= chunk_end; row += Lanes)
+									{
+										solve_row_lanes(row);
+									}
+								}
+								for (; row < chunk_end; ++row)
+								{
+									solve_row(row);
+								}
+							}
+
+							colors_done.arrive_and_wait();
+						}
+					};
+
+				sweep_colors(true);
+				if (settings.substeps == 0)
+				{
+					for (u32 iteration = 0; iteration < settings.iterations; ++iteration)
+					{
+						sweep_colors(false);
+					}
+					return;
+				}
+
+				//biases and positions are split evenly regardless of colour, with a wait before anyone reads what they wrote
+				const u32 row_start = begin + static_cast<u32>(chunk_begin(row_count, worker, worker_count));
+				const u32 row_end = begin + static_cast<u32>(chunk_begin(row_count, worker + 1, worker_count));
+				const u32 body_start = body_begin + static_cast<u32>(chunk_begin(body_count, worker, worker_count));
+				const u32 body_end = body_begin + static_cast<u32>(chunk_begin(body_count, worker + 1, worker_count));
+				const f32 substep_time = delta_time / static_cast<f32>(settings.substeps);
+				const f32 inverse_substep_time = 1.0f / substep_time;
+				for (u32 substep = 0; substep < settings.substeps; ++substep)
+				{
+					refresh_bias(row_start, row_end, settings.baumgarte * inverse_substep_time, inverse_substep_time, settings.penetration_slop);
+					colors_done.arrive_and_wait();
+					sweep_colors(false);
+					integrate_positions(body_start, body_end, substep_time);
+					colors_done.arrive_and_wait();
+				}
+
+				refresh_bias(row_start, row_end, 0.0f, 1.0f / delta_time, settings.penetration_slop);
+				colors_done.arrive_and_wait();
+				sweep_colors(false);
+			});
+	}
+
+	void contact_solver::solve(entity_registry& registry, std::vector<collision_pair> const& contacts, std::vector<math::contact_manifold3<f32>>& manifolds,
+		contact_solver_settings const& settings, f32 delta_time)
+	{
+		JM_MATH_ASSERT(contacts.size() == manifolds.size());
+
+		//substeps need a step to split
+		contact_solver_settings step_settings = settings;
+		step_settings.substeps = delta_time > 0.0f ? settings.substeps : 0;
+
+		build_rows(registry, contacts, manifolds, settings, delta_time);
+		const u32 row_count = static_cast<u32>(rows.impulse.size());
+		build_islands(get_worker_count(settings.thread_count, row_count, MinRowsPerThread), settings.graph_coloring);
+
+		const u32 task_row_count = island_row_offsets[colored_island_begin];
+		color_count = 0;
+		if (task_row_count < row_count)
+		{
+			build_colors();
+		}
+
+		//Rewind the bodies to the pose integrate started them from, which holds whatever the integrator or a CCD clamp did,
+		//and let the substeps move them again
+		if (step_settings.substeps > 0)
+		{
+			for (u32 body = 1; body <= static_cast<u32>(dynamic_body_count); ++body)
+			{
+				const entity_id entity = body_entities[body];
+				spatial3_component const& spatial = registry.get<spatial3_component>(entity);
+				const math::vector3_f32 delta = registry.get<linear_body3_component>(entity).start_position - spatial.position;
+				const rotational_body3_component* rotational = registry.try_get<rotational_body3_component>(entity);
+				const math::vector3_f32 rotation = rotational != nullptr ? get_rotation(spatial.orientation, rotational->start_orientation) : math::zero3;
+				for (u32 component = 0; component < 3; ++component)
+				{
+					bodies.delta[component][body] = delta[component];
+					bodies.rotation[component][body] = rotation[component];
+				}
+			}
+		}
+
+		//each task takes a run of whole islands, split where the row count crosses an even share
+		const u32 task_count = get_worker_count(settings.thread_count, task_row_count, MinRowsPerThread);
+		pool->run(task_count, [this, task_row_count, task_count, &step_settings, delta_time](u32 task)
+			{
+				auto island_boundary = [this](uSize row)
+					{
+						return static_cast<u32>(std::lower_bound(island_row_offsets.begin(), island_row_offsets.end(), static_cast<u32>(row)) - island_row_offsets.begin());
+					};
+				const u32 island_begin = island_boundary(chunk_begin(task_row_count, task, task_count));
+				const u32 island_end = island_boundary(chunk_begin(task_row_count, task + 1, task_count));
+				if (step_settings.substeps > 0)
+				{
+					solve_substeps(island_begin, island_end, step_settings, delta_time);
+				}
+				else
+				{
+					solve_rows(island_row_offsets[island_begin], island_row_offsets[island_end], step_settings.iterations);
+				}
+			});
+
+		//islands too large for one task are solved colour by colour across every worker
+		if (task_row_count < row_count)
+		{
+			solve_colors(get_worker_count(settings.thread_count, row_count - task_row_count, MinRowsPerThread), step_settings, delta_time);
+		}
+
+		for (u32 body = 1; body <= static_cast<u32>(dynamic_body_count); ++body)
+		{
+			const entity_id entity = body_entities[body];
+			registry.get<linear_body3_component>(entity).velocity = { bodies.velocity[0][body], bodies.velocity[1][body], bodies.velocity[2][body] };
+			rotational_body3_component* rotational = registry.try_get<rotational_body3_component>(entity);
+			if (rotational != nullptr)
+			{
+				rotational->velocity = { bodies.angular_velocity[0][body], bodies.angular_velocity[1][body], bodies.angular_velocity[2][body] };
+			}
+			if (step_settings.substeps > 0)
+			{
+				spatial3_component& spatial = registry.get<spatial3_component>(entity);
+				spatial.position += math::vector3_f32{ bodies.delta[0][body], bodies.delta[1][body], bodies.delta[2][body] };
+				const math::vector3_f32 rotation{ bodies.rotation[0][body], bodies.rotation[1][body], bodies.rotation[2][body] };
+				const f32 angle = glm::length(rotation);
+				if (rotational != nullptr && angle > math::epsilon<f32>())
+				{
+					spatial.orientation = glm::normalize(glm::angleAxis(angle, rotation / angle) * spatial.orientation);
+				}
+			}
+			entity_bodies[static_cast<uSize>(entt::to_entity(entity))] = InvalidBody;
+		}
+		for (u32 slot = 0; slot < static_cast<u32>(dynamic_body_count); ++slot)
+		{
+			const u32 body = island_bodies[slot];
+			island_velocities[slot] = { bodies.velocity[0][body], bodies.velocity[1][body], bodies.velocity[2][body] };
+		}
+
+		for (u32 row = 0; row < row_count; ++row)
+		{
+			if (rows.manifold[row] < contacts.size())
+			{
+				math::contact_point3<f32>& point = manifolds[rows.manifold[row]].points[rows.point[row]];
+				point.normal_impulse = rows.impulse[row];
+				point.tangent_impulse = { rows.tangent_impulse[row], rows.bitangent_impulse[row] };
+				point.rolling_impulse = { rows.roll_tangent_impulse[row], rows.roll_bitangent_impulse[row] };
+				point.tangent = { rows.tangent.linear[0][row], rows.tangent.linear[1][row], rows.tangent.linear[2][row] };
+			}
+			else
+			{
+				joint_component& joint = registry.get<joint_component>(joint_entities[rows.manifold[row] - contacts.size()]);
+				(rows.point[row] < 3 ? joint.impulse[rows.point[row]] : joint.angular_impulse[rows.point[row] - 3]) = rows.impulse[row];
+			}
+		}
+	}
+}
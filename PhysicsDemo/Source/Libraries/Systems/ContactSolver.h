@@ -0,0 +1,200 @@
+#pragma once
+
+#include "Entity.h"
+#include "Broadphase.h"
+#include "Math/Contact.h"
+#include "Math/DisjointSet.h"
+#include "Workers.h"
+
+#include <array>
+#include <span>
+
+namespace jm
+{
+	struct contact_solver_settings
+	{
+		u32 iterations = 8;
+		f32 baumgarte = 0.2f; //fraction of the penetration pushed out per step
+		f32 penetration_slop = 0.01f; //penetration left alone so resting contacts do not jitter
+		f32 friction = 0.5f; //Coulomb coefficient, a contact's tangent impulse stays within this times its normal impulse
+		f32 rolling_resistance = 0.02f; //a sphere contact's turning impulse stays within this times the radius and its normal impulse
+		u32 thread_count = 0; //zero uses every hardware thread, small worlds stay on one regardless
+		bool graph_coloring = true; //split islands too large for one task into colours solved across every worker
+		u32 substeps = 0; //zero runs iterations of Gauss-Seidel, otherwise the step is split into this many substeps of one iteration each
+	};
+
+	struct island_stats
+	{
+		static constexpr uSize HistogramBuckets = 12;
+
+		uSize island_count = 0;
+		uSize largest_island = 0; //bodies
+		std::array<uSize, HistogramBuckets> size_histogram{}; //islands with [2^i, 2^(i+1)) bodies in bucket i, the last takes everything larger
+	};
+
+	//Projected Gauss-Seidel over one non-penetration row per contact point and one row per direction a joint holds. Bodies and
+	//rows are packed as structures of arrays, statics have zero inverse mass and inertia and joints differ from contacts only in
+	//the lower bound of their impulse, so no row needs a branch. Every direction a row acts along has an angular part for each
+	//body, the lever arm crossed with it, so contacts and joints off a body's centre turn it. A row also carries friction along
+	//two tangents, solved just before its normal and kept inside the cone of the normal impulse, which joints leave closed.
+	//Contacts of spheres also resist rolling, turning the bodies against each other about the two tangents within a cone of
+	//the normal impulse as well.
+	//Impulses and the tangent basis start from the values stored on the manifold points and joint components and are written
+	//back so the next update can warm start. With substeps only contacts warm start, see warm_start_substeps.
+	//Bodies touching through contacts are grouped into islands, statics do not join islands. Islands share no body, so runs of
+	//them are solved as separate tasks. Rows of islands too large for one task are coloured so no two rows of a colour share a
+	//body, then each colour is split across the workers and solved four rows at a time. Either way the result does not depend
+	//on the thread count.
+	//With substeps the solve is temporal Gauss-Seidel. Bodies are rewound to the pose integrate started them from and moved and
+	//turned again substep by substep, each row's bias following its separation as the bodies move, after which one pass without
+	//the push out takes the correction velocity back off. Contacts and lever arms are still found once per step.
+	class contact_solver
+	{
+	public:
+		explicit contact_solver(worker_pool& pool) : pool(&pool) {} //pool must outlive the solver
+
+		void solve(entity_registry& registry, std::vector<collision_pair> const& contacts, std::vector<math::contact_manifold3<f32>>& manifolds,
+			contact_solver_settings const& settings, f32 delta_time);
+
+		uSize get_body_count() const { return dynamic_body_count; }
+		uSize get_row_count() const { return rows.impulse.size(); }
+		uSize get_joint_row_count() const { return joint_row_count; }
+		uSize get_color_count() const { return color_count; } //zero when no island was large enough to colour
+
+		island_stats const& get_island_stats() const { return stats; }
+		u32 get_island_count() const { return static_cast<u32>(island_body_offsets.size() - 1); }
+
+		//bodies of an island from the last solve, valid until the next one
+		std::span<entity_id const> get_island_entities(u32 island) const
+		{
+			return { island_entities.data() + island_body_offsets[island], island_entities.data() + island_body_offsets[island + 1] };
+		}
+
+		//velocities the last solve left those bodies with, in the same order
+		std::span<math::vector3<f32> const> get_island_velocities(u32 island) const
+		{
+			return { island_velocities.data() + island_body_offsets[island], island_velocities.data() + island_body_offsets[island + 1] };
+		}
+
+	private:
+		static constexpr u32 InvalidBody = ~u32(0);
+		static constexpr u32 StaticBody = 0;
+		static constexpr uSize MinRowsPerThread = 2048; //fewer are not worth handing to another thread
+		static constexpr u32 MinColoredRows = 1024; //islands with fewer rows are left to a single task
+		static constexpr u32 ColorWords = 2; //a row takes up to two colours at each body it touches, a box in a pile has ~50 rows
+		static constexpr u32 OverflowColor = 64 * ColorWords;
+		static constexpr u32 Lanes = 4;
+
+		static constexpr uSize BodyFields = 13;
+		static constexpr uSize AxisFields = 16;
+		static constexpr uSize TurnFields = 7;
+		static constexpr uSize RowFields = 3 * AxisFields + 2 * TurnFields + 10;
+
+		struct body_arrays
+		{
+			std::array<std::vector<f32>, 3> velocity, angular_velocity; //angular in world axes
+			std::array<std::vector<f32>, 3> delta; //substeps only, position relative to where the manifolds were found
+			std::array<std::vector<f32>, 3> rotation; //substeps only, the same for the orientation as a small angle
+			std::vector<f32> inverse_mass;
+
+			std::array<std::vector<f32>*, BodyFields> fields();
+		};
+
+		//one direction of a row, as the Jacobian and the angular velocity each body gains per unit impulse along it
+		struct jacobian
+		{
+			math::vector3<f32> linear{}; //-linear on a and +linear on b
+			math::vector3<f32> angular_a{}; //-angular_a on a, the lever arm crossed with linear for a point
+			math::vector3<f32> angular_b{}; //+angular_b on b
+		};
+
+		struct axis_arrays
+		{
+			std::array<std::vector<f32>, 3> linear, angular_a, angular_b;
+			std::array<std::vector<f32>, 3> response_a, response_b; //the angular parts through the inverse inertia of their body
+			std::vector<f32> effective_mass;
+
+			std::array<std::vector<f32>*, AxisFields> fields();
+		};
+
+		//turning both bodies about one of a row's tangents, whose direction is the angular part for each
+		struct turn_arrays
+		{
+			std::array<std::vector<f32>, 3> response_a, response_b;
+			std::vector<f32> effective_mass;
+
+			std::array<std::vector<f32>*, TurnFields> fields();
+		};
+
+		struct row_arrays
+		{
+			std::vector<u32> body_a, body_b;
+			axis_arrays normal;
+			axis_arrays tangent, bitangent; //friction directions at the same point, bitangent is cross(normal, tangent)
+			turn_arrays roll_tangent, roll_bitangent; //rolling resistance about tangent and bitangent
+			std::vector<f32> bias, impulse;
+			std::vector<f32> tangent_impulse, bitangent_impulse;
+			std::vector<f32> friction; //zero on joint rows
+			std::vector<f32> rolling_resistance, roll_tangent_impulse, roll_bitangent_impulse; //zero unless a sphere touches
+			std::vector<f32> lower_impulse; //zero for contacts, unbounded for joints which pull as well as push
+			std::vector<f32> separation; //along the normal where the manifold was found, negative when overlapping
+			std::vector<u32> manifold, point; //where the impulse is written back, joint rows number their joints after the manifolds and their turning rows from 3
+
+			std::array<std::vector<f32>*, RowFields> fields(); //every f32 field
+		};
+
+		u32 get_body(entity_registry& registry, entity_id entity);
+		void set_axis(axis_arrays& axis, u32 row, jacobian const& jacobian);
+		void add_row(u32 body_a, u32 body_b, jacobian const& normal, f32 bias, f32 impulse, f32 separation, f32 lower_impulse, u32 manifold, u32 point);
+		void set_friction(u32 row, jacobian const& tangent, jacobian const& bitangent, math::vector2<f32> const& impulse, f32 friction); //add_row leaves none
+		void set_turn(turn_arrays& turn, u32 row, math::vector3<f32> const& axis);
+		void set_rolling(u32 row, math::vector2<f32> const& impulse, f32 rolling_resistance); //about the tangents set_friction left
+		void build_rows(entity_registry& registry, std::vector<collision_pair> const& contacts, std::vector<math::contact_manifold3<f32>> const& manifolds,
+			contact_solver_settings const& settings, f32 delta_time);
+		void build_islands(u32 worker_count, bool color_large_islands);
+		void build_colors();
+		void permute_rows(); //by row_order
+		template <typename Lane>
+		void solve_row_as(u32 row); //one row when Lane is f32, Lanes rows when it is four wide
+		void solve_row(u32 row);
+		void solve_row_lanes(u32 row); //rows row to row + Lanes - 1, which must not share a body
+		void solve_rows(u32 begin, u32 end, u32 iterations);
+		void solve_substeps(u32 island_begin, u32 island_end, contact_solver_settings const& settings, f32 delta_time);
+		void solve_colors(u32 worker_count, contact_solver_settings const& settings, f32 delta_time);
+		void warm_start_substeps(u32 begin, u32 end);
+		void refresh_bias(u32 begin, u32 end, f32 push_rate, f32 approach_rate, f32 penetration_slop); //from the current separation
+		void integrate_positions(u32 begin, u32 end, f32 substep_time); //island_bodies begin to end
+		void apply_impulse(u32 row); //the impulses accumulated in the row
+		void apply_axis(axis_arrays const& axis, u32 row, f32 impulse);
+		void apply_turn(turn_arrays const& turn, u32 row, f32 impulse);
+
+		worker_pool* pool;
+		std::vector<entity_id> joint_entities; //joints with rows this update, a joint row's manifold less the manifold count indexes it
+		uSize joint_row_count = 0;
+		std::vector<entity_id> body_entities; //solver body to entity, body zero stands in for every static until islands are built
+		std::vector<u32> entity_bodies; //entity index to solver body
+		uSize dynamic_body_count = 0;
+		body_arrays bodies;
+		std::vector<math::matrix33<f32>> inverse_inertias; //world axes, per solver body while the rows are built
+		row_arrays rows;
+		row_arrays sorted_rows;
+		std::vector<u32> row_order; //row gathered into each sorted slot
+
+		math::disjoint_set body_sets;
+		std::vector<u32> body_islands;
+		std::vector<u32> island_body_offsets = { 0 };
+		std::vector<u32> island_row_offsets = { 0 };
+		std::vector<entity_id> island_entities;
+		std::vector<u32> island_bodies; //solver bodies in the same order as island_entities
+		std::vector<math::vector3<f32>> island_velocities;
+		std::vector<u32> island_order; //to colour large islands they are renumbered after the rest
+		std::vector<u32> island_scratch;
+		u32 colored_island_begin = 0;
+		island_stats stats;
+
+		std::vector<u64> body_colors; //ColorWords per body, bit per colour used by the body's rows
+		std::vector<u32> row_colors;
+		std::vector<u32> color_offsets; //coloured rows of each colour, relative to the first coloured row
+		uSize color_count = 0;
+	};
+}
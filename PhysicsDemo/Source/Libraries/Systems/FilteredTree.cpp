@@ -0,0 +1,37 @@
+#include "FilteredTree.h"
+
+namespace jm
+{
+	filtered_aabb_tree::filtered_aabb_tree(std::vector<entity_id> const& entities, std::vector<collision_filter> const& filters, std::vector<math::aabb3<f32>> const& bounds)
+		: primitive_count(entities.size())
+	{
+		JM_MATH_ASSERT(entities.size() == filters.size() && entities.size() == bounds.size());
+
+		//worlds use a handful of filters, so finding a shape's layer by walking them is cheaper than hashing
+		std::vector<u32> shape_layers(entities.size());
+		for (uSize idx = 0; idx < entities.size(); ++idx)
+		{
+			u32 found = 0;
+			while (found < layers.size() && (layers[found].filter.group != filters[idx].group || layers[found].filter.mask != filters[idx].mask))
+			{
+				++found;
+			}
+			if (found == layers.size())
+			{
+				layers.emplace_back().filter = filters[idx];
+			}
+			layers[found].entities.push_back(entities[idx]);
+			shape_layers[idx] = found;
+		}
+
+		std::vector<std::vector<math::aabb3<f32>>> layer_bounds(layers.size());
+		for (uSize idx = 0; idx < entities.size(); ++idx)
+		{
+			layer_bounds[shape_layers[idx]].push_back(bounds[idx]);
+		}
+		for (uSize idx = 0; idx < layers.size(); ++idx)
+		{
+			layers[idx].tree = math::static_aabb_tree<f32>(std::move(layer_bounds[idx]));
+		}
+	}
+}
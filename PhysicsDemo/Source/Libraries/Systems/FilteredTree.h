@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Broadphase.h"
+#include "Math/StaticTree.h"
+
+namespace jm
+{
+	//Shapes that hold still while it stands, baked into one static tree per distinct collision filter. A query passes over
+	//every tree whose filter cannot collide with its own before any bounds test, so shapes on other layers cost nothing.
+	class filtered_aabb_tree
+	{
+	public:
+		filtered_aabb_tree() = default;
+
+		//entities, filters and bounds in parallel, one per shape
+		filtered_aabb_tree(std::vector<entity_id> const& entities, std::vector<collision_filter> const& filters, std::vector<math::aabb3<f32>> const& bounds);
+
+		//Calls callback(entity) for every shape whose bounds overlap bounds and whose filter can collide with filter. Returns
+		//how many shapes were passed over by their filter.
+		template <typename Fxn>
+		uSize query(collision_filter const& filter, math::aabb3<f32> const& bounds, Fxn&& callback) const
+		{
+			uSize filtered = 0;
+			for (layer const& current : layers)
+			{
+				if (!can_collide(filter, current.filter))
+				{
+					filtered += current.entities.size();
+					continue;
+				}
+
+				current.tree.query(bounds, [&](u32 primitive)
+					{
+						callback(current.entities[primitive]);
+						return true;
+					});
+			}
+			return filtered;
+		}
+
+		uSize get_primitive_count() const { return primitive_count; }
+		uSize get_layer_count() const { return layers.size(); }
+
+	private:
+		struct layer
+		{
+			collision_filter filter;
+			std::vector<entity_id> entities; //indexed by tree primitive
+			math::static_aabb_tree<f32> tree;
+		};
+
+		std::vector<layer> layers;
+		uSize primitive_count = 0;
+	};
+}
@@ -75,23 +75,32 @@ namespace jm::System
 		return Renderer.ImGuiContextPtr->GetMessageHandler();
 	}
 
-	void Graphics::Draw3D(math::camera3<f32> const& camera, std::function<void()> && imguiFrame)
+	void Graphics::Draw3D(math::camera3<f32> const& camera, f32 interpolation, std::function<void()> && imguiFrame)
 	{
-		auto spatial_shape_view = EntityRegistry.view<const spatial3_component, const shape_component>();
+		auto interpolated_view = EntityRegistry.view<const spatial3_component, const previous_spatial3_component, const shape_component>();
+		auto spatial_shape_view = EntityRegistry.view<const spatial3_component, const shape_component>(entt::exclude<previous_spatial3_component>);
 
 		std::vector<math::matrix44_f32> CubeInstances;
 		std::vector<math::matrix44_f32> SphereInstances;
+		auto add_instance = [&CubeInstances, &SphereInstances](spatial3_component const& pose, shape_component shape)
+			{
+				switch (shape)
+				{
+				case shape_component::Sphere:
+					SphereInstances.push_back(math::isometry_matrix3(pose.position, pose.orientation));
+					break;
+				default:  //box
+					CubeInstances.push_back(math::isometry_matrix3(pose.position, pose.orientation));
+					break;
+				}
+			};
+		for (auto&& [entity, spatial, previous, shape] : interpolated_view.each())
+		{
+			add_instance(math::interpolate(previous.pose, spatial, interpolation), shape);
+		}
 		for (auto&& [entity, spatial, shape] : spatial_shape_view.each())
 		{
-			switch (shape)
-			{
-			case shape_component::Sphere:
-				SphereInstances.push_back(math::isometry_matrix3(spatial.position, spatial.orientation));
-				break;
-			default:  //box
-				CubeInstances.push_back(math::isometry_matrix3(spatial.position, spatial.orientation));
-				break;
-			}
+			add_instance(spatial, shape);
 		}
 
 
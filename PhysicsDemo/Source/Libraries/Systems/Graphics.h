@@ -37,7 +37,8 @@ namespace jm::System
 		
 		Platform::MessageHandler* GetMessageHandler();
 
-		void Draw3D(math::camera3<f32> const& camera, std::function<void()>&& imguiFrame);
+		//bodies with a previous_spatial3_component are drawn `interpolation` of the way from their previous pose to their current one
+		void Draw3D(math::camera3<f32> const& camera, f32 interpolation, std::function<void()>&& imguiFrame);
 		void ImGuiDebug();
 	};
 }
\ No newline at end of file
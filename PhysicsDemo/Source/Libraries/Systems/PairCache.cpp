@@ -0,0 +1,29 @@
+#include "PairCache.h"
+
+namespace jm
+{
+	void collision_pair_cache::update(std::vector<collision_pair> const& touching, collision_events& events)
+	{
+		events.begin.clear();
+		events.persist.clear();
+		events.end.clear();
+		++tick;
+
+		pairs.begin_update();
+		for (collision_pair const& pair : touching)
+		{
+			auto [state, inserted, first_visit] = pairs.visit(pair);
+			if (inserted)
+			{
+				state.first_tick = tick;
+				events.begin.push_back(pair);
+			}
+			else if (first_visit)
+			{
+				events.persist.push_back(pair);
+			}
+		}
+
+		pairs.end_update([&](collision_pair const& pair, contact_state const&) { events.end.push_back(pair); });
+	}
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "Broadphase.h"
+
+#include <algorithm>
+
+namespace jm
+{
+	//Per pair state kept across updates. Stored in an open addressing table with linear probing keyed by entity pair,
+	//erased with backward shifting so there are no tombstones. Pairs not visited since begin_update are dropped by end_update.
+	template <typename Value>
+	class collision_pair_map
+	{
+	public:
+		struct visit_result
+		{
+			Value& value;
+			bool inserted; //the pair was not in the map, value is default constructed
+			bool first_visit; //first visit since begin_update
+		};
+
+		void begin_update()
+		{
+			++tick;
+			visited = 0;
+		}
+
+		//the value reference is only valid until the next visit, which may grow the table
+		visit_result visit(collision_pair const& pair)
+		{
+			reserve(count + 1);
+
+			entry& slot = entries[find_slot(pair)];
+			const bool inserted = slot.empty();
+			if (inserted)
+			{
+				slot.pair = pair;
+				slot.value = Value{};
+				++count;
+			}
+
+			const bool first_visit = slot.last_seen != tick;
+			slot.last_seen = tick;
+			visited += first_visit ? 1 : 0;
+			return { slot.value, inserted, first_visit };
+		}
+
+		//calls on_removed(pair, value) for every pair not visited since begin_update, then erases them
+		template <typename Fxn>
+		void end_update(Fxn&& on_removed)
+		{
+			//the table does not shrink, skip the scan when every pair was visited so an emptied world costs nothing
+			if (visited == count)
+			{
+				return;
+			}
+
+			stale.clear();
+			for (entry& slot : entries)
+			{
+				if (!slot.empty() && slot.last_seen != tick)
+				{
+					on_removed(slot.pair, slot.value);
+					stale.push_back(slot.pair);
+				}
+			}
+
+			//erasing shifts later entries back, so look each pair up again rather than erasing during the scan
+			for (collision_pair const& pair : stale)
+			{
+				erase_slot(find_slot(pair));
+			}
+		}
+
+		Value* find(collision_pair const& pair)
+		{
+			if (entries.empty())
+			{
+				return nullptr;
+			}
+
+			entry& slot = entries[find_slot(pair)];
+			return slot.empty() ? nullptr : &slot.value;
+		}
+
+		bool contains(collision_pair const& pair) const
+		{
+			return !entries.empty() && !entries[find_slot(pair)].empty();
+		}
+
+		void clear()
+		{
+			entries.clear();
+			count = 0;
+			visited = 0;
+		}
+
+		uSize size() const { return count; }
+		uSize capacity() const { return entries.size(); }
+
+	private:
+		static constexpr uSize MinCapacity = 64;
+
+		struct entry
+		{
+			collision_pair pair{ null_entity_id, null_entity_id };
+			u32 last_seen = 0;
+			Value value{};
+
+			bool empty() const { return pair.a == null_entity_id; }
+		};
+
+		uSize home_slot(collision_pair const& pair) const
+		{
+			//splitmix64 finaliser, entity ids are sequential so the raw key would cluster
+			u64 key = (u64(entt::to_integral(pair.a)) << 32) | entt::to_integral(pair.b);
+			key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+			key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+			key = key ^ (key >> 31);
+			return static_cast<uSize>(key) & (entries.size() - 1);
+		}
+
+		//slot holding pair, or the empty slot it would go in
+		uSize find_slot(collision_pair const& pair) const
+		{
+			const uSize mask = entries.size() - 1;
+			uSize slot = home_slot(pair);
+			while (!entries[slot].empty() && !(entries[slot].pair == pair))
+			{
+				slot = (slot + 1) & mask;
+			}
+			return slot;
+		}
+
+		void erase_slot(uSize slot)
+		{
+			const uSize mask = entries.size() - 1;
+			uSize hole = slot;
+			for (uSize next = (slot + 1) & mask; !entries[next].empty(); next = (next + 1) & mask)
+			{
+				//an entry can fill the hole only if the hole lies between its home slot and where it sits now
+				const uSize home = home_slot(entries[next].pair);
+				if (((next - home) & mask) >= ((next - hole) & mask))
+				{
+					entries[hole] = std::move(entries[next]);
+					hole = next;
+				}
+			}
+			entries[hole] = entry{};
+			--count;
+		}
+
+		void reserve(uSize pair_count)
+		{
+			//keep the load factor at or below one half so probe runs stay short
+			uSize new_capacity = std::max(entries.size(), MinCapacity);
+			while (pair_count * 2 > new_capacity)
+			{
+				new_capacity *= 2;
+			}
+			if (new_capacity == entries.size())
+			{
+				return;
+			}
+
+			std::vector<entry> old_entries(new_capacity);
+			std::swap(entries, old_entries);
+			for (entry& old_entry : old_entries)
+			{
+				if (!old_entry.empty())
+				{
+					entries[find_slot(old_entry.pair)] = std::move(old_entry);
+				}
+			}
+		}
+
+		std::vector<entry> entries; //power of two sized
+		std::vector<collision_pair> stale;
+		uSize count = 0;
+		uSize visited = 0; //distinct pairs visited since begin_update
+		u32 tick = 0;
+	};
+
+	//batched contact events, every cached pair lands in exactly one list per update
+	struct collision_events
+	{
+		std::vector<collision_pair> begin; //started touching this update
+		std::vector<collision_pair> persist; //touching this update and the previous one
+		std::vector<collision_pair> end; //stopped touching, or lost an entity, since the previous update
+	};
+
+	struct contact_state
+	{
+		u32 first_tick = 0; //update the pair started touching on
+	};
+
+	//touching pairs kept across updates so per contact state survives between ticks
+	class collision_pair_cache
+	{
+	public:
+		//touching may hold duplicates, each pair is only reported once
+		void update(std::vector<collision_pair> const& touching, collision_events& events);
+		void clear() { pairs.clear(); }
+
+		bool contains(collision_pair const& pair) const { return pairs.contains(pair); }
+		contact_state* find(collision_pair const& pair) { return pairs.find(pair); }
+		uSize size() const { return pairs.size(); }
+		uSize capacity() const { return pairs.capacity(); }
+
+	private:
+		collision_pair_map<contact_state> pairs;
+		u32 tick = 0;
+	};
+}
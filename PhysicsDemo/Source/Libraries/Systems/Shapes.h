@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Components.h"
+#include "Math/Geometry.h"
+
+namespace jm
+{
+	//the geometry behind a shape_component at a spatial
+	inline math::sphere3<f32> make_sphere(spatial3_component const& spatial)
+	{
+		return { spatial.position, 1.0f }; //assume unit radius spheres
+	}
+
+	inline math::box3<f32> make_box(spatial3_component const& spatial)
+	{
+		return { spatial.position, math::vector3_f32{ 1.0f }, glm::mat3_cast(spatial.orientation) }; //assume unit extent boxes
+	}
+
+	//principal moments of a solid shape_component of the given mass, for a rotational_body3_component
+	inline math::vector3<f32> make_inertia(shape_component shape, f32 mass)
+	{
+		return math::vector3_f32{ shape == shape_component::Sphere ? 0.4f * mass : mass * (2.0f / 3.0f) }; //unit radius, or 2 across each side
+	}
+
+	//distance from the centre to the nearest point of the surface, a body moving further than this in a step can pass through its own kind
+	inline f32 get_inner_radius(shape_component)
+	{
+		return 1.0f; //unit radius spheres and unit extent boxes alike
+	}
+
+	inline math::aabb3<f32> make_bounds(shape_component shape, spatial3_component const& spatial)
+	{
+		return shape == shape_component::Sphere ? math::bounding_box(make_sphere(spatial)) : math::bounding_box(make_box(spatial));
+	}
+}
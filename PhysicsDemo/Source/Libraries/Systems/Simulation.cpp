@@ -4,33 +4,292 @@
 #include "MathTypes.h"
 #include "Components.h"
 
+#include <algorithm>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
 namespace jm
 {
-	constexpr f32 Damping = 0.9995f;
-	constexpr math::vector3<f32> Gravity = { 0.f, -9.81f, 0.f };
-	constexpr math::vector2<f32> Gravity2 = { Gravity.x, Gravity.y};
+	namespace
+	{
+		constexpr u32 Lanes = 4;
+
+		static_assert(offsetof(math::quaternion<f32>, w) == 0 && offsetof(math::quaternion<f32>, z) == 3 * sizeof(f32), "orientations are loaded as w, x, y, z");
+
+		//component i of four vectors, each read as four floats so the fourth is whatever follows it in its component
+		struct lanes3
+		{
+			__m128 x, y, z;
+		};
+
+		lanes3 load_lanes(f32 const* first, f32 const* second, f32 const* third, f32 const* fourth)
+		{
+			__m128 x = _mm_loadu_ps(first), y = _mm_loadu_ps(second), z = _mm_loadu_ps(third), w = _mm_loadu_ps(fourth);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			return { x, y, z };
+		}
+
+		//Four bodies in lanes. Lanes past count are given a resting body at the identity so every lane reads something, only
+		//the first count are written back. Loading whole vectors and transposing them keeps the gather out of memory, writing
+		//lanes one float at a time and loading them back stalls on every load.
+		void integrate_rotation_lanes(rotational_body3_component* const* rotationals, spatial3_component* const* spatials, u32 count, f32 delta_time)
+		{
+			static rotational_body3_component const idle_rotational{ math::zero3, math::vector3<f32>{ 1.0f } };
+			static spatial3_component const idle_spatial{ math::zero3, math::quaternion<f32>{ 1.0f, 0.0f, 0.0f, 0.0f } };
+			rotational_body3_component const* rotational[Lanes];
+			spatial3_component const* spatial[Lanes];
+			for (u32 lane = 0; lane < Lanes; ++lane)
+			{
+				rotational[lane] = lane < count ? rotationals[lane] : &idle_rotational;
+				spatial[lane] = lane < count ? spatials[lane] : &idle_spatial;
+			}
+
+			__m128 qw = _mm_loadu_ps(&spatial[0]->orientation.w);
+			__m128 qx = _mm_loadu_ps(&spatial[1]->orientation.w);
+			__m128 qy = _mm_loadu_ps(&spatial[2]->orientation.w);
+			__m128 qz = _mm_loadu_ps(&spatial[3]->orientation.w);
+			_MM_TRANSPOSE4_PS(qw, qx, qy, qz);
+			const lanes3 velocity = load_lanes(&rotational[0]->velocity.x, &rotational[1]->velocity.x, &rotational[2]->velocity.x, &rotational[3]->velocity.x);
+			const lanes3 torque = load_lanes(&rotational[0]->applied_torque.x, &rotational[1]->applied_torque.x, &rotational[2]->applied_torque.x, &rotational[3]->applied_torque.x);
+			const lanes3 inverse = load_lanes(&rotational[0]->inverse_inertia.x, &rotational[1]->inverse_inertia.x, &rotational[2]->inverse_inertia.x, &rotational[3]->inverse_inertia.x);
+
+			const __m128 dt = _mm_set1_ps(delta_time);
+			const __m128 half_dt = _mm_set1_ps(0.5f * delta_time);
+			const __m128 damping = _mm_set1_ps(Damping);
+
+			//Shapes with the same moment about every axis, which is all of them so far, have a world inverse inertia that is just
+			//that moment, the orientation only matters for the rest. Theirs stays the diagonal the constructor left.
+			__m128 accelerate_x, accelerate_y, accelerate_z;
+			alignas(16) f32 world_inverse[6][Lanes];
+			const bool isotropic = _mm_movemask_ps(_mm_and_ps(_mm_cmpeq_ps(inverse.x, inverse.y), _mm_cmpeq_ps(inverse.x, inverse.z))) == 0xF;
+			if (isotropic)
+			{
+				accelerate_x = _mm_mul_ps(inverse.x, torque.x);
+				accelerate_y = _mm_mul_ps(inverse.x, torque.y);
+				accelerate_z = _mm_mul_ps(inverse.x, torque.z);
+			}
+			else
+			{
+				//rotation matrix of the orientation, r_ij takes body axis j to world axis i
+				const __m128 one = _mm_set1_ps(1.0f);
+				const __m128 two = _mm_set1_ps(2.0f);
+				const __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+				const __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+				const __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+				const __m128 r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+				const __m128 r01 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+				const __m128 r02 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+				const __m128 r10 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+				const __m128 r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+				const __m128 r12 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+				const __m128 r20 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+				const __m128 r21 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+				const __m128 r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+				//world inverse inertia is r * diag(inverse) * transpose(r), symmetric so six terms cover it
+				const __m128 a00 = _mm_mul_ps(r00, inverse.x), a01 = _mm_mul_ps(r01, inverse.y), a02 = _mm_mul_ps(r02, inverse.z);
+				const __m128 a10 = _mm_mul_ps(r10, inverse.x), a11 = _mm_mul_ps(r11, inverse.y), a12 = _mm_mul_ps(r12, inverse.z);
+				const __m128 a20 = _mm_mul_ps(r20, inverse.x), a21 = _mm_mul_ps(r21, inverse.y), a22 = _mm_mul_ps(r22, inverse.z);
+				const __m128 world_xx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a00, r00), _mm_mul_ps(a01, r01)), _mm_mul_ps(a02, r02));
+				const __m128 world_xy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a00, r10), _mm_mul_ps(a01, r11)), _mm_mul_ps(a02, r12));
+				const __m128 world_xz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a00, r20), _mm_mul_ps(a01, r21)), _mm_mul_ps(a02, r22));
+				const __m128 world_yy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a10, r10), _mm_mul_ps(a11, r11)), _mm_mul_ps(a12, r12));
+				const __m128 world_yz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a10, r20), _mm_mul_ps(a11, r21)), _mm_mul_ps(a12, r22));
+				const __m128 world_zz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a20, r20), _mm_mul_ps(a21, r21)), _mm_mul_ps(a22, r22));
+				_mm_store_ps(world_inverse[0], world_xx);
+				_mm_store_ps(world_inverse[1], world_xy);
+				_mm_store_ps(world_inverse[2], world_xz);
+				_mm_store_ps(world_inverse[3], world_yy);
+				_mm_store_ps(world_inverse[4], world_yz);
+				_mm_store_ps(world_inverse[5], world_zz);
+
+				accelerate_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(world_xx, torque.x), _mm_mul_ps(world_xy, torque.y)), _mm_mul_ps(world_xz, torque.z));
+				accelerate_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(world_xy, torque.x), _mm_mul_ps(world_yy, torque.y)), _mm_mul_ps(world_yz, torque.z));
+				accelerate_z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(world_xz, torque.x), _mm_mul_ps(world_yz, torque.y)), _mm_mul_ps(world_zz, torque.z));
+			}
+
+			//same order as the linear update, the torque then damping then the turn at the new velocity
+			const __m128 velocity_x = _mm_mul_ps(_mm_add_ps(velocity.x, _mm_mul_ps(accelerate_x, dt)), damping);
+			const __m128 velocity_y = _mm_mul_ps(_mm_add_ps(velocity.y, _mm_mul_ps(accelerate_y, dt)), damping);
+			const __m128 velocity_z = _mm_mul_ps(_mm_add_ps(velocity.z, _mm_mul_ps(accelerate_z, dt)), damping);
+
+			//the orientation's derivative is half the velocity as a pure quaternion times the orientation
+			const __m128 dw = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(_mm_add_ps(_mm_mul_ps(velocity_x, qx), _mm_mul_ps(velocity_y, qy)), _mm_mul_ps(velocity_z, qz)));
+			const __m128 dx = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(velocity_x, qw), _mm_mul_ps(velocity_y, qz)), _mm_mul_ps(velocity_z, qy));
+			const __m128 dy = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(velocity_y, qw), _mm_mul_ps(velocity_z, qx)), _mm_mul_ps(velocity_x, qz));
+			const __m128 dz = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(velocity_z, qw), _mm_mul_ps(velocity_x, qy)), _mm_mul_ps(velocity_y, qx));
+			qw = _mm_add_ps(qw, _mm_mul_ps(dw, half_dt));
+			qx = _mm_add_ps(qx, _mm_mul_ps(dx, half_dt));
+			qy = _mm_add_ps(qy, _mm_mul_ps(dy, half_dt));
+			qz = _mm_add_ps(qz, _mm_mul_ps(dz, half_dt));
+
+			//The step leaves the squared length at one plus (velocity * dt / 2)^2, close enough to one that one Newton step from
+			//one stands in for the inverse square root for anything turning under a radian a step. What it misses comes out the
+			//next update, and unlike the estimate instruction it gives the same result on every processor.
+			const __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qw, qw), _mm_mul_ps(qx, qx)), _mm_add_ps(_mm_mul_ps(qy, qy), _mm_mul_ps(qz, qz)));
+			const __m128 inverse_length = _mm_mul_ps(_mm_set1_ps(0.5f), _mm_sub_ps(_mm_set1_ps(3.0f), length_squared));
+			qx = _mm_mul_ps(qx, inverse_length);
+			qy = _mm_mul_ps(qy, inverse_length);
+			qz = _mm_mul_ps(qz, inverse_length);
+			qw = _mm_mul_ps(qw, inverse_length);
+
+			//back to one orientation per register, the rest goes out through memory as the velocity is followed by the inertia
+			_MM_TRANSPOSE4_PS(qw, qx, qy, qz);
+			const __m128 orientations[Lanes] = { qw, qx, qy, qz };
+			alignas(16) f32 velocities[3][Lanes];
+			_mm_store_ps(velocities[0], velocity_x);
+			_mm_store_ps(velocities[1], velocity_y);
+			_mm_store_ps(velocities[2], velocity_z);
+			for (u32 lane = 0; lane < count; ++lane)
+			{
+				_mm_storeu_ps(&spatials[lane]->orientation.w, orientations[lane]);
+				rotationals[lane]->velocity = { velocities[0][lane], velocities[1][lane], velocities[2][lane] };
+				if (!isotropic)
+				{
+					rotationals[lane]->world_inverse_inertia = {
+						world_inverse[0][lane], world_inverse[1][lane], world_inverse[2][lane],
+						world_inverse[1][lane], world_inverse[3][lane], world_inverse[4][lane],
+						world_inverse[2][lane], world_inverse[4][lane], world_inverse[5][lane] };
+				}
+			}
+		}
+
+		void wake_island_of(entity_registry& registry, entity_id entity)
+		{
+			if (sleeping_component const* sleeping = registry.try_get<sleeping_component>(entity))
+			{
+				const u32 island = sleeping->island;
+				std::vector<entity_id> woken;
+				wake_sleeping_islands(registry, { &island, 1 }, woken);
+			}
+		}
+
+		//bodies gathered a chunk at a time and then run through in lanes, which keeps the walk that finds them out of the arithmetic
+		struct rotation_chunk
+		{
+			static constexpr u32 Size = 64 * Lanes;
+
+			void add(rotational_body3_component& rotational, spatial3_component& spatial, f32 delta_time)
+			{
+				rotational.start_orientation = spatial.orientation;
+				rotationals[count] = &rotational;
+				spatials[count] = &spatial;
+				if (++count == Size)
+				{
+					flush(delta_time);
+				}
+			}
 
+			void flush(f32 delta_time)
+			{
+				for (u32 first = 0; first < count; first += Lanes)
+				{
+					integrate_rotation_lanes(rotationals + first, spatials + first, std::min(count - first, Lanes), delta_time);
+				}
+				count = 0;
+			}
+
+			rotational_body3_component* rotationals[Size];
+			spatial3_component* spatials[Size];
+			u32 count = 0;
+		};
+	}
+
+	void wake_sleeping_islands(entity_registry& registry, std::span<u32 const> islands, std::vector<entity_id>& woken)
+	{
+		woken.clear();
+		for (auto&& [entity, sleeping] : registry.storage<sleeping_component>().each())
+		{
+			if (std::binary_search(islands.begin(), islands.end(), sleeping.island))
+			{
+				woken.push_back(entity);
+			}
+		}
+
+		for (entity_id entity : woken)
+		{
+			if (linear_body3_component* linear = registry.try_get<linear_body3_component>(entity))
+			{
+				spatial3_component const& spatial = registry.get<spatial3_component>(entity);
+				linear->start_position = spatial.position;
+				if (rotational_body3_component* rotational = registry.try_get<rotational_body3_component>(entity))
+				{
+					rotational->start_orientation = spatial.orientation;
+				}
+			}
+		}
+		registry.remove<sleeping_component>(woken.begin(), woken.end());
+	}
+
+	void apply_force(entity_registry& registry, entity_id entity, math::vector3<f32> const& force)
+	{
+		registry.get<linear_body3_component>(entity).applied_force += force;
+		wake_island_of(registry, entity);
+	}
+
+	void apply_torque(entity_registry& registry, entity_id entity, math::vector3<f32> const& torque)
+	{
+		registry.get<rotational_body3_component>(entity).applied_torque += torque;
+		wake_island_of(registry, entity);
+	}
+
+	template <typename Integrator>
 	void integrate(entity_registry& registry, f32 delta_time)
 	{
+		//forces are held over the step, so the acceleration does not depend on where the step has got to
 		{
 			auto lin_sim_view = registry.view<spatial2_component, linear_body2_component>();
 			for (auto&& [entity, spatial, linear] : lin_sim_view.each())
 			{
-				math::vector2_f32 acceleration = Gravity2 + linear.applied_force * linear.inverse_mass;
-				math::euler_integration(linear.velocity, acceleration, deltaTime);
-				linear.velocity *= Damping;
-				math::euler_integration(spatial.position, linear.velocity, deltaTime);
+				const math::vector2_f32 acceleration = Gravity2 + linear.applied_force * linear.inverse_mass;
+				Integrator::step(spatial.position, linear.velocity, [&acceleration](math::vector2_f32 const&, math::vector2_f32 const&) { return acceleration; },
+					Damping, delta_time);
 			}
 		}
 		{
-			auto lin_sim_view = registry.view<spatial3_component, linear_body3_component>();
-			for (auto&& [entity, spatial, linear] : lin_sim_view.each())
+			auto continuous_view = registry.view<const spatial3_component, continuous_collision_component>(entt::exclude<sleeping_component>);
+			for (auto&& [entity, spatial, continuous] : continuous_view.each())
+			{
+				continuous.start_position = spatial.position;
+			}
+		}
+		{
+			for (auto&& [entity, linear, spatial] : get_awake_bodies(registry).each())
 			{
-				math::vector3_f32 acceleration = Gravity + linear.applied_force * linear.inverse_mass;
-				math::euler_integration(linear.velocity, acceleration, deltaTime);
-				linear.velocity *= Damping;
-				math::euler_integration(spatial.position, linear.velocity, deltaTime);
+				linear.start_position = spatial.position;
+				const math::vector3_f32 acceleration = Gravity + linear.applied_force * linear.inverse_mass;
+				Integrator::step(spatial.position, linear.velocity, [&acceleration](math::vector3_f32 const&, math::vector3_f32 const&) { return acceleration; },
+					Damping, delta_time);
 			}
 		}
+		integrate_rotations(registry, delta_time);
+	}
+
+	template void integrate<math::explicit_euler>(entity_registry& registry, f32 delta_time);
+	template void integrate<math::semi_implicit_euler>(entity_registry& registry, f32 delta_time);
+	template void integrate<math::velocity_verlet>(entity_registry& registry, f32 delta_time);
+	template void integrate<math::runge_kutta4>(entity_registry& registry, f32 delta_time);
+
+	void store_previous_poses(entity_registry& registry)
+	{
+		for (auto&& [entity, spatial, previous] : registry.view<const spatial3_component, previous_spatial3_component>().each())
+		{
+			previous.pose = spatial;
+		}
+	}
+
+	void integrate_rotations(entity_registry& registry, f32 delta_time)
+	{
+		rotation_chunk rotations;
+		for (auto&& [entity, rotational, spatial] : get_awake_rotating_bodies(registry).each())
+		{
+			rotations.add(rotational, spatial, delta_time);
+		}
+		rotations.flush(delta_time);
 	}
-}
\ No newline at end of file
+}
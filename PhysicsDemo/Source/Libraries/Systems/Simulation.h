@@ -2,8 +2,67 @@
 
 #include "MathTypes.h"
 #include "Entity.h"
+#include "Components.h"
+
+#include <span>
+#include <vector>
 
 namespace jm
 {
+	constexpr f32 Damping = 0.9995f; //velocity kept per update
+	constexpr math::vector3<f32> Gravity = { 0.f, -9.81f, 0.f };
+	constexpr math::vector2<f32> Gravity2 = { Gravity.x, Gravity.y};
+
+	//Every body that is not sleeping. The group owns its components, so the awake bodies sit packed at the front of their
+	//pools in the order it walks them, kept that way as sleeping tags come and go. A world that has come to rest costs
+	//nothing to iterate where a view would still walk every body, and the walk reads memory in order without lookups.
+	inline auto get_awake_bodies(entity_registry& registry)
+	{
+		return registry.group<linear_body3_component, spatial3_component>(entt::get<>, entt::exclude<sleeping_component>);
+	}
+
+	//The awake bodies with a rotational_body3_component. The group owns that component, so a walk over it reads them packed
+	//in order and only looks up the spatials.
+	inline auto get_awake_rotating_bodies(entity_registry& registry)
+	{
+		return registry.group<rotational_body3_component>(entt::get<spatial3_component>, entt::exclude<sleeping_component>);
+	}
+
+	//where one end of a joint is in the world, on the world itself the anchor is already a point
+	inline math::vector3<f32> get_joint_anchor(entity_registry const& registry, entity_id body, math::vector3<f32> const& local_anchor)
+	{
+		if (body == null_entity_id)
+		{
+			return local_anchor;
+		}
+
+		spatial3_component const& spatial = registry.get<spatial3_component>(body);
+		return spatial.position + spatial.orientation * local_anchor;
+	}
+
+	//Wakes every body of the sleeping islands, given sorted and without repeats, and puts them in woken. Their start pose is
+	//moved to where they lie, so a solver that rewinds to it leaves bodies woken after integrate in place.
+	void wake_sleeping_islands(entity_registry& registry, std::span<u32 const> islands, std::vector<entity_id>& woken);
+
+	//adds to the force a body feels every update and wakes its island, writing applied_force directly leaves a sleeping body asleep
+	void apply_force(entity_registry& registry, entity_id entity, math::vector3<f32> const& force);
+
+	//adds to the torque a body feels every update and wakes its island, like apply_force
+	void apply_torque(entity_registry& registry, entity_id entity, math::vector3<f32> const& torque);
+
+	//Advances the awake bodies by their velocity and the forces on them, integrate_rotations included, recording the pose each
+	//starts from for solver substeps to rewind to. Integrator is one of the policies in Math/Physics.h, those four are
+	//instantiated in Simulation.cpp. Rotations keep their first order step.
+	template <typename Integrator = math::semi_implicit_euler>
 	void integrate(entity_registry& registry, f32 delta_time);
+
+	//Copies every pose into its previous_spatial3_component before an update, sleeping bodies included so one that fell asleep
+	//mid-motion is not drawn short of where it stopped
+	void store_previous_poses(entity_registry& registry);
+
+	//Turns the orientation of every awake body with a rotational_body3_component by its angular velocity, after the applied
+	//torque through the inverse inertia in world axes, worked out once per body from the orientation it starts the update
+	//with and kept on the component for the solver. Orientations are renormalized every update so the error of the first
+	//order step never builds up.
+	void integrate_rotations(entity_registry& registry, f32 delta_time);
 }
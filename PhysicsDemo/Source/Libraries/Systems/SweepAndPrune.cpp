@@ -0,0 +1,278 @@
+#include "SweepAndPrune.h"
+
+#include <algorithm>
+
+namespace jm
+{
+	namespace
+	{
+		bool is_max(u32 data)
+		{
+			return (data & 1) != 0;
+		}
+
+		u32 box_of(u32 data)
+		{
+			return data >> 1;
+		}
+
+		//mins sort before maxes on ties so touching bounds count as overlapping, matching math::intersect
+		template <typename Endpoint>
+		bool comes_before(Endpoint const& left, Endpoint const& right)
+		{
+			return left.value < right.value || (left.value == right.value && !is_max(left.data) && is_max(right.data));
+		}
+	}
+
+	u64 sweep_and_prune_broadphase::pair_key(u32 first, u32 second) const
+	{
+		return first < second ? (u64(first) << 32) | second : (u64(second) << 32) | first;
+	}
+
+	collision_pair sweep_and_prune_broadphase::entity_pair(u64 key) const
+	{
+		return make_collision_pair(boxes[u32(key >> 32)].entity, boxes[u32(key)].entity);
+	}
+
+	void sweep_and_prune_broadphase::find_pairs(std::vector<collision_proxy> const& proxies, std::vector<collision_pair>& pairs)
+	{
+		update(proxies, scratch_changes);
+
+		pairs.clear();
+		pairs.reserve(overlapping.size());
+		for (u64 key : overlapping)
+		{
+			pairs.push_back(entity_pair(key));
+		}
+		std::sort(pairs.begin(), pairs.end());
+	}
+
+	void sweep_and_prune_broadphase::find_pair_changes(std::vector<collision_proxy> const& proxies, collision_pair_changes& changes)
+	{
+		update(proxies, changes);
+	}
+
+	void sweep_and_prune_broadphase::update(std::vector<collision_proxy> const& proxies, collision_pair_changes& changes)
+	{
+		++tick;
+		changes.added.clear();
+		changes.removed.clear();
+		stats = { proxies.size(), 0, 0 };
+
+		new_proxies.clear();
+		for (u32 idx = 0; idx < static_cast<u32>(proxies.size()); ++idx)
+		{
+			collision_proxy const& proxy = proxies[idx];
+			const uSize entity_index = static_cast<uSize>(entt::to_entity(proxy.entity));
+			if (entity_index >= entity_boxes.size())
+			{
+				entity_boxes.resize(entity_index + 1, InvalidBox);
+			}
+
+			const u32 box = entity_boxes[entity_index];
+			if (box != InvalidBox && boxes[box].entity == proxy.entity)
+			{
+				boxes[box].last_bounds = boxes[box].bounds;
+				boxes[box].bounds = proxy.bounds;
+				boxes[box].filter = proxy.filter;
+				boxes[box].last_seen = tick;
+			}
+			else
+			{
+				new_proxies.push_back(idx);
+			}
+		}
+
+		remove_stale_boxes(changes);
+
+		for (uSize axis = 0; axis < axes.size(); ++axis)
+		{
+			for (endpoint& point : axes[axis])
+			{
+				sap_box const& box = boxes[box_of(point.data)];
+				point.value = is_max(point.data) ? box.bounds.max[static_cast<glm::length_t>(axis)] : box.bounds.min[static_cast<glm::length_t>(axis)];
+			}
+			sort_axis(axis, changes);
+		}
+
+		if (!new_proxies.empty())
+		{
+			insert_new_boxes(proxies, changes);
+		}
+
+		stats.candidate_pairs = overlapping.size();
+	}
+
+	void sweep_and_prune_broadphase::insert_new_boxes(std::vector<collision_proxy> const& proxies, collision_pair_changes& changes)
+	{
+		is_new_box.assign(boxes.size(), 0);
+		for (u32 idx : new_proxies)
+		{
+			collision_proxy const& proxy = proxies[idx];
+
+			u32 box = static_cast<u32>(boxes.size());
+			if (free_boxes.empty())
+			{
+				boxes.emplace_back();
+			}
+			else
+			{
+				box = free_boxes.back();
+				free_boxes.pop_back();
+			}
+
+			boxes[box] = { proxy.entity, proxy.bounds, proxy.bounds, proxy.filter, tick };
+			entity_boxes[static_cast<uSize>(entt::to_entity(proxy.entity))] = box;
+			is_new_box.resize(boxes.size(), 0);
+			is_new_box[box] = 1;
+		}
+
+		//inserting one at a time through the insertion sort is quadratic for a batch, so sort the batch and merge it in
+		for (uSize axis = 0; axis < axes.size(); ++axis)
+		{
+			std::vector<endpoint>& points = axes[axis];
+			const auto old_end = static_cast<std::ptrdiff_t>(points.size());
+			for (u32 box = 0; box < static_cast<u32>(boxes.size()); ++box)
+			{
+				if (is_new_box[box] != 0)
+				{
+					points.push_back({ boxes[box].bounds.min[static_cast<glm::length_t>(axis)], box << 1 });
+					points.push_back({ boxes[box].bounds.max[static_cast<glm::length_t>(axis)], (box << 1) | 1 });
+				}
+			}
+			std::sort(points.begin() + old_end, points.end(), comes_before<endpoint>);
+			std::inplace_merge(points.begin(), points.begin() + old_end, points.end(), comes_before<endpoint>);
+		}
+
+		//one sweep along x finds every overlap involving a new box, old boxes only need testing against new ones
+		std::vector<u32> active_old;
+		std::vector<u32> active_new;
+		for (endpoint const& point : axes[0])
+		{
+			const u32 box = box_of(point.data);
+			std::vector<u32>& own_list = is_new_box[box] != 0 ? active_new : active_old;
+			if (is_max(point.data))
+			{
+				own_list.erase(std::find(own_list.begin(), own_list.end(), box));
+				continue;
+			}
+
+			auto test = [&](u32 other)
+			{
+				if (!can_collide(boxes[box].filter, boxes[other].filter))
+				{
+					++stats.filtered_pairs;
+					return;
+				}
+
+				++stats.tested_pairs;
+				if (math::intersect(boxes[box].bounds, boxes[other].bounds) && overlapping.insert(pair_key(box, other)).second)
+				{
+					changes.added.push_back(entity_pair(pair_key(box, other)));
+				}
+			};
+
+			std::for_each(active_new.begin(), active_new.end(), test);
+			if (is_new_box[box] != 0)
+			{
+				std::for_each(active_old.begin(), active_old.end(), test);
+			}
+			own_list.push_back(box);
+		}
+	}
+
+	void sweep_and_prune_broadphase::remove_stale_boxes(collision_pair_changes& changes)
+	{
+		auto is_stale = [this](u32 box)
+		{
+			return boxes[box].entity != null_entity_id && boxes[box].last_seen != tick;
+		};
+
+		bool any_stale = false;
+		for (u32 box = 0; box < static_cast<u32>(boxes.size()) && !any_stale; ++box)
+		{
+			any_stale = is_stale(box);
+		}
+		if (!any_stale)
+		{
+			return;
+		}
+
+		for (auto it = overlapping.begin(); it != overlapping.end();)
+		{
+			if (is_stale(u32(*it >> 32)) || is_stale(u32(*it)))
+			{
+				changes.removed.push_back(entity_pair(*it));
+				it = overlapping.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		for (auto& axis : axes)
+		{
+			std::erase_if(axis, [&](endpoint const& point) { return is_stale(box_of(point.data)); });
+		}
+
+		for (u32 box = 0; box < static_cast<u32>(boxes.size()); ++box)
+		{
+			if (is_stale(box))
+			{
+				u32& mapped_box = entity_boxes[static_cast<uSize>(entt::to_entity(boxes[box].entity))];
+				if (mapped_box == box)
+				{
+					mapped_box = InvalidBox;
+				}
+				boxes[box].entity = null_entity_id;
+				free_boxes.push_back(box);
+			}
+		}
+	}
+
+	void sweep_and_prune_broadphase::sort_axis(uSize axis, collision_pair_changes& changes)
+	{
+		std::vector<endpoint>& points = axes[axis];
+		for (uSize idx = 1; idx < points.size(); ++idx)
+		{
+			const endpoint moving = points[idx];
+
+			uSize jdx = idx;
+			for (; jdx > 0 && comes_before(moving, points[jdx - 1]); --jdx)
+			{
+				const endpoint passed = points[jdx - 1];
+				if (is_max(moving.data) != is_max(passed.data))
+				{
+					const u32 first = box_of(moving.data);
+					const u32 second = box_of(passed.data);
+					const u64 key = pair_key(first, second);
+					if (!is_max(moving.data))
+					{
+						//a min moving below a max: the pair may have started overlapping
+						if (!can_collide(boxes[first].filter, boxes[second].filter))
+						{
+							++stats.filtered_pairs;
+						}
+						else
+						{
+							++stats.tested_pairs;
+							if (math::intersect(boxes[first].bounds, boxes[second].bounds) && overlapping.insert(key).second)
+							{
+								changes.added.push_back(entity_pair(key));
+							}
+						}
+					}
+					else if (math::intersect(boxes[first].last_bounds, boxes[second].last_bounds) && overlapping.erase(key) != 0)
+					{
+						//a max moving below a min: the pair is separated on this axis, and only pairs that
+						//overlapped last update can be in the set, which skips most of the hash lookups
+						changes.removed.push_back(entity_pair(key));
+					}
+				}
+				points[jdx] = passed;
+			}
+			points[jdx] = moving;
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Broadphase.h"
+
+#include <array>
+#include <unordered_set>
+
+namespace jm
+{
+	//Incremental sweep and prune over all three axes. Endpoint arrays stay sorted between updates and are
+	//re-sorted with insertion sort, so coherent motion costs close to O(n) and every swap of a min past a max
+	//is exactly one pair starting or stopping to overlap, which makes the pair changes fall out for free.
+	class sweep_and_prune_broadphase final : public broadphase
+	{
+	public:
+		void find_pairs(std::vector<collision_proxy> const& proxies, std::vector<collision_pair>& pairs) override;
+		void find_pair_changes(std::vector<collision_proxy> const& proxies, collision_pair_changes& changes) override;
+
+	private:
+		static constexpr u32 InvalidBox = ~u32(0);
+
+		struct endpoint
+		{
+			f32 value;
+			u32 data; //box index << 1 | is max
+		};
+
+		struct sap_box
+		{
+			entity_id entity = null_entity_id;
+			math::aabb3<f32> bounds;
+			math::aabb3<f32> last_bounds; //bounds at the previous update, the pair set matches their overlaps
+			collision_filter filter;
+			u32 last_seen = 0;
+		};
+
+		void update(std::vector<collision_proxy> const& proxies, collision_pair_changes& changes);
+		void remove_stale_boxes(collision_pair_changes& changes);
+		void insert_new_boxes(std::vector<collision_proxy> const& proxies, collision_pair_changes& changes);
+		void sort_axis(uSize axis, collision_pair_changes& changes);
+
+		u64 pair_key(u32 first, u32 second) const;
+		collision_pair entity_pair(u64 key) const;
+
+		std::array<std::vector<endpoint>, 3> axes;
+		std::vector<sap_box> boxes;
+		std::vector<u32> free_boxes;
+		std::vector<u32> entity_boxes; //entity index to box
+		std::vector<u32> new_proxies;
+		std::vector<u8> is_new_box;
+		std::unordered_set<u64> overlapping;
+		collision_pair_changes scratch_changes;
+		u32 tick = 0;
+	};
+}
@@ -0,0 +1,124 @@
+#include "TreeBroadphase.h"
+
+#include <algorithm>
+
+namespace jm
+{
+	dynamic_tree_broadphase::dynamic_tree_broadphase(f32 margin)
+		: tree(margin)
+	{
+	}
+
+	u64 dynamic_tree_broadphase::pair_key(u32 first, u32 second) const
+	{
+		return first < second ? (u64(first) << 32) | second : (u64(second) << 32) | first;
+	}
+
+	void dynamic_tree_broadphase::find_pairs(std::vector<collision_proxy> const& proxies, std::vector<collision_pair>& pairs)
+	{
+		++tick;
+		stats = { proxies.size(), 0, 0 };
+
+		moved_leaves.clear();
+		for (collision_proxy const& proxy : proxies)
+		{
+			const uSize entity_index = static_cast<uSize>(entt::to_entity(proxy.entity));
+			if (entity_index >= entity_leaves.size())
+			{
+				entity_leaves.resize(entity_index + 1, InvalidLeaf);
+			}
+
+			u32 leaf = entity_leaves[entity_index];
+			if (leaf != InvalidLeaf && leaves[leaf].entity == proxy.entity)
+			{
+				leaves[leaf].bounds = proxy.bounds;
+				leaves[leaf].filter = proxy.filter;
+				leaves[leaf].moved = tree.move_proxy(leaves[leaf].proxy, proxy.bounds);
+			}
+			else
+			{
+				if (free_leaves.empty())
+				{
+					leaf = static_cast<u32>(leaves.size());
+					leaves.emplace_back();
+				}
+				else
+				{
+					leaf = free_leaves.back();
+					free_leaves.pop_back();
+				}
+
+				leaves[leaf] = { proxy.entity, tree.create_proxy(proxy.bounds, leaf), proxy.bounds, proxy.filter, tick, true };
+				entity_leaves[entity_index] = leaf;
+			}
+
+			leaves[leaf].last_seen = tick;
+			if (leaves[leaf].moved)
+			{
+				moved_leaves.push_back(leaf);
+			}
+		}
+
+		//leaves that vanished are destroyed and, like moved leaves, lose all their pairs
+		for (u32 leaf = 0; leaf < static_cast<u32>(leaves.size()); ++leaf)
+		{
+			tree_leaf& stale = leaves[leaf];
+			if (stale.entity != null_entity_id && stale.last_seen != tick)
+			{
+				u32& mapped_leaf = entity_leaves[static_cast<uSize>(entt::to_entity(stale.entity))];
+				if (mapped_leaf == leaf)
+				{
+					mapped_leaf = InvalidLeaf;
+				}
+				tree.destroy_proxy(stale.proxy);
+				stale = tree_leaf{};
+				stale.moved = true;
+				free_leaves.push_back(leaf);
+			}
+		}
+
+		std::erase_if(fat_pairs, [this](u64 key) { return leaves[u32(key >> 32)].moved || leaves[u32(key)].moved; });
+
+		for (u32 leaf : moved_leaves)
+		{
+			tree.query(tree.get_fat_bounds(leaves[leaf].proxy), [&](i32 proxy)
+				{
+					const u32 other = tree.get_user_data(proxy);
+					if (other == leaf)
+					{
+						return true;
+					}
+
+					if (can_collide(leaves[leaf].filter, leaves[other].filter))
+					{
+						fat_pairs.insert(pair_key(leaf, other));
+					}
+					else
+					{
+						++stats.filtered_pairs;
+					}
+					return true;
+				});
+		}
+
+		for (tree_leaf& leaf : leaves)
+		{
+			leaf.moved = false;
+		}
+
+		pairs.clear();
+		for (u64 key : fat_pairs)
+		{
+			tree_leaf const& first = leaves[u32(key >> 32)];
+			tree_leaf const& second = leaves[u32(key)];
+			if (math::intersect(first.bounds, second.bounds))
+			{
+				pairs.push_back(make_collision_pair(first.entity, second.entity));
+			}
+		}
+		std::sort(pairs.begin(), pairs.end());
+
+		stats.tested_pairs = fat_pairs.size();
+		stats.candidate_pairs = pairs.size();
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Broadphase.h"
+#include "Math/DynamicTree.h"
+
+#include <unordered_set>
+
+namespace jm
+{
+	//Broadphase over a dynamic AABB tree, suited to bodies of very different sizes. Only proxies that escape their
+	//fat bounds are reinserted and re-queried, pairs between resting proxies carry over from the previous update.
+	class dynamic_tree_broadphase final : public broadphase
+	{
+	public:
+		explicit dynamic_tree_broadphase(f32 margin);
+
+		void find_pairs(std::vector<collision_proxy> const& proxies, std::vector<collision_pair>& pairs) override;
+
+		//calls callback(entity) for every proxy whose fat bounds overlap bounds, stops early if it returns false
+		template <typename Fxn>
+		void query(math::aabb3<f32> const& bounds, Fxn&& callback) const
+		{
+			tree.query(bounds, [&](i32 proxy) { return callback(leaves[tree.get_user_data(proxy)].entity); });
+		}
+
+		//calls callback(entity, max_t) for every proxy whose fat bounds the ray enters, see math::dynamic_aabb_tree::ray_cast
+		template <typename Fxn>
+		void ray_cast(math::ray3<f32> const& ray, f32 max_t, Fxn&& callback) const
+		{
+			tree.ray_cast(ray, max_t, [&](i32 proxy, f32 t) { return callback(leaves[tree.get_user_data(proxy)].entity, t); });
+		}
+
+		math::dynamic_aabb_tree<f32> const& get_tree() const { return tree; }
+
+	private:
+		static constexpr u32 InvalidLeaf = ~u32(0);
+
+		struct tree_leaf
+		{
+			entity_id entity = null_entity_id;
+			i32 proxy = math::dynamic_aabb_tree<f32>::null_node;
+			math::aabb3<f32> bounds; //tight bounds, the tree only keeps the fat ones
+			collision_filter filter;
+			u32 last_seen = 0;
+			bool moved = false;
+		};
+
+		u64 pair_key(u32 first, u32 second) const;
+
+		math::dynamic_aabb_tree<f32> tree;
+		std::vector<tree_leaf> leaves;
+		std::vector<u32> free_leaves;
+		std::vector<u32> entity_leaves; //entity index to leaf
+		std::vector<u32> moved_leaves;
+		std::unordered_set<u64> fat_pairs; //pairs of leaves whose fat bounds overlap
+		u32 tick = 0;
+	};
+}
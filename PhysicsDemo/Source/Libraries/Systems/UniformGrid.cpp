@@ -0,0 +1,274 @@
+#include "UniformGrid.h"
+#include "Workers.h"
+
+#include <algorithm>
+#include <array>
+
+namespace jm
+{
+	namespace
+	{
+		constexpr u64 CellBits = 21;
+		constexpr u64 CellMask = (u64(1) << CellBits) - 1;
+		constexpr i64 CellBias = i64(1) << (CellBits - 1);
+
+		struct cell_coordinate
+		{
+			i64 x, y, z;
+		};
+
+		u64 pack_cell(cell_coordinate const& cell)
+		{
+			return (u64(cell.x + CellBias) & CellMask)
+				| ((u64(cell.y + CellBias) & CellMask) << CellBits)
+				| ((u64(cell.z + CellBias) & CellMask) << (2 * CellBits));
+		}
+
+		//neighbouring cells are visited with cursors that only move forward, so coordinates are clamped
+		//one cell short of the packing range to keep key + offset from wrapping
+		constexpr i64 CellLimit = CellBias - 2;
+
+		//the forward half of the 26 neighbours, so every pair of neighbouring cells is visited once
+		constexpr std::array<cell_coordinate, 13> HalfNeighbourhood = { {
+			{ 1, 0, 0 },
+			{ -1, 1, 0 }, { 0, 1, 0 }, { 1, 1, 0 },
+			{ -1, -1, 1 }, { 0, -1, 1 }, { 1, -1, 1 },
+			{ -1, 0, 1 }, { 0, 0, 1 }, { 1, 0, 1 },
+			{ -1, 1, 1 }, { 0, 1, 1 }, { 1, 1, 1 }
+		} };
+
+		constexpr i64 key_offset(cell_coordinate const& offset)
+		{
+			return offset.x + offset.y * (i64(1) << CellBits) + offset.z * (i64(1) << (2 * CellBits));
+		}
+	}
+
+	uniform_grid_broadphase::uniform_grid_broadphase(worker_pool& pool, f32 cell_size, u32 thread_count)
+		: pool(&pool)
+		, cell_size(cell_size)
+		, thread_count(thread_count)
+	{
+		JM_MATH_ASSERT(cell_size > 0.f);
+	}
+
+	void uniform_grid_broadphase::set_cell_size(f32 size)
+	{
+		JM_MATH_ASSERT(size > 0.f);
+		cell_size = size;
+	}
+
+	void uniform_grid_broadphase::set_thread_count(u32 count)
+	{
+		thread_count = count;
+	}
+
+	void uniform_grid_broadphase::build_cells(std::vector<collision_proxy> const& proxies, u32 worker_count)
+	{
+		//bounds built from a radius pick up rounding, so a body exactly one cell wide must still count as fitting
+		const f32 fit_size = cell_size * 1.0001f;
+		const f32 inverse_cell_size = 1.f / cell_size;
+		const auto by_cell = [](cell_entry const& left, cell_entry const& right)
+			{
+				return left.key < right.key || (left.key == right.key && left.proxy < right.proxy);
+			};
+
+		//each worker bins and sorts a contiguous slice of the proxies
+		pool->run(worker_count, [&](u32 worker)
+			{
+				worker_output& output = workers[worker];
+				output.entries.clear();
+				output.oversized.clear();
+
+				const u32 end = static_cast<u32>(chunk_begin(proxies.size(), worker + 1, worker_count));
+				for (u32 idx = static_cast<u32>(chunk_begin(proxies.size(), worker, worker_count)); idx < end; ++idx)
+				{
+					const math::aabb3<f32>& bounds = proxies[idx].bounds;
+					const math::vector3_f32 extent = math::size(bounds);
+					if (extent.x > fit_size || extent.y > fit_size || extent.z > fit_size)
+					{
+						output.oversized.push_back({ 0, idx, bounds, proxies[idx].filter });
+						continue;
+					}
+
+					const math::vector3_f32 cell = glm::clamp(glm::floor(math::center(bounds) * inverse_cell_size), f32(-CellLimit), f32(CellLimit));
+					output.entries.push_back({ pack_cell({ i64(cell.x), i64(cell.y), i64(cell.z) }), idx, bounds, proxies[idx].filter });
+				}
+
+				std::sort(output.entries.begin(), output.entries.end(), by_cell);
+			});
+
+		if (worker_count == 1)
+		{
+			std::swap(entries, workers[0].entries);
+			std::swap(oversized, workers[0].oversized);
+			return;
+		}
+
+		//then the sorted slices are merged pairwise, halving the number of runs each round
+		entries.clear();
+		oversized.clear();
+		std::vector<uSize> runs = { 0 };
+		for (u32 worker = 0; worker < worker_count; ++worker)
+		{
+			entries.insert(entries.end(), workers[worker].entries.begin(), workers[worker].entries.end());
+			oversized.insert(oversized.end(), workers[worker].oversized.begin(), workers[worker].oversized.end());
+			runs.push_back(entries.size());
+		}
+
+		while (runs.size() > 2)
+		{
+			const u32 merge_count = static_cast<u32>((runs.size() - 1) / 2);
+			pool->run(merge_count, [&](u32 merge)
+				{
+					const auto first = entries.begin() + runs[2 * merge];
+					std::inplace_merge(first, entries.begin() + runs[2 * merge + 1], entries.begin() + runs[2 * merge + 2], by_cell);
+				});
+
+			std::vector<uSize> merged_runs;
+			for (uSize run = 0; run < runs.size(); run += 2)
+			{
+				merged_runs.push_back(runs[run]);
+			}
+			if (merged_runs.back() != runs.back())
+			{
+				merged_runs.push_back(runs.back());
+			}
+			runs = std::move(merged_runs);
+		}
+	}
+
+	void uniform_grid_broadphase::find_cell_pairs(std::vector<collision_proxy> const& proxies, u32 begin_entry, u32 end_entry, worker_output& output) const
+	{
+		output.pairs.clear();
+		output.tested_pairs = 0;
+		output.filtered_pairs = 0;
+		if (begin_entry == end_entry)
+		{
+			return;
+		}
+
+		auto test = [&](cell_entry const& first, cell_entry const& second)
+		{
+			if (!can_collide(first.filter, second.filter))
+			{
+				++output.filtered_pairs;
+				return;
+			}
+
+			++output.tested_pairs;
+			if (math::intersect(first.bounds, second.bounds))
+			{
+				output.pairs.push_back(make_collision_pair(proxies[first.proxy].entity, proxies[second.proxy].entity));
+			}
+		};
+
+		//cells are sorted by key, so the key of each forward neighbour only ever increases as we walk them
+		std::array<u32, HalfNeighbourhood.size()> cursors{};
+		for (uSize offset = 0; offset < HalfNeighbourhood.size(); ++offset)
+		{
+			const u64 neighbour_key = entries[begin_entry].key + key_offset(HalfNeighbourhood[offset]);
+			cursors[offset] = static_cast<u32>(std::partition_point(entries.begin(), entries.end(),
+				[neighbour_key](cell_entry const& entry) { return entry.key < neighbour_key; }) - entries.begin());
+		}
+
+		for (u32 begin = begin_entry; begin < end_entry;)
+		{
+			const u64 key = entries[begin].key;
+			u32 end = begin + 1;
+			while (end < end_entry && entries[end].key == key)
+			{
+				++end;
+			}
+
+			for (u32 idx = begin; idx < end; ++idx)
+			{
+				for (u32 jdx = idx + 1; jdx < end; ++jdx)
+				{
+					test(entries[idx], entries[jdx]);
+				}
+			}
+
+			for (uSize offset = 0; offset < HalfNeighbourhood.size(); ++offset)
+			{
+				const u64 neighbour_key = key + key_offset(HalfNeighbourhood[offset]);
+
+				u32& neighbour = cursors[offset];
+				while (neighbour < entries.size() && entries[neighbour].key < neighbour_key)
+				{
+					++neighbour;
+				}
+
+				for (u32 jdx = neighbour; jdx < entries.size() && entries[jdx].key == neighbour_key; ++jdx)
+				{
+					for (u32 idx = begin; idx < end; ++idx)
+					{
+						test(entries[idx], entries[jdx]);
+					}
+				}
+			}
+
+			begin = end;
+		}
+	}
+
+	void uniform_grid_broadphase::find_pairs(std::vector<collision_proxy> const& proxies, std::vector<collision_pair>& pairs)
+	{
+		pairs.clear();
+		stats = { proxies.size(), 0, 0 };
+
+		const u32 worker_count = get_worker_count(thread_count, proxies.size(), MinProxiesPerThread);
+		workers.resize(std::max<uSize>(workers.size(), worker_count));
+		build_cells(proxies, worker_count);
+
+		//split the sorted entries evenly, moving each split forward to the start of a cell so no cell is shared
+		std::vector<u32> splits(worker_count + 1, static_cast<u32>(entries.size()));
+		splits[0] = 0;
+		for (u32 worker = 1; worker < worker_count; ++worker)
+		{
+			u32 split = std::max(splits[worker - 1], static_cast<u32>(chunk_begin(entries.size(), worker, worker_count)));
+			while (split > 0 && split < entries.size() && entries[split].key == entries[split - 1].key)
+			{
+				++split;
+			}
+			splits[worker] = split;
+		}
+
+		pool->run(worker_count, [&](u32 worker) { find_cell_pairs(proxies, splits[worker], splits[worker + 1], workers[worker]); });
+
+		for (u32 worker = 0; worker < worker_count; ++worker)
+		{
+			pairs.insert(pairs.end(), workers[worker].pairs.begin(), workers[worker].pairs.end());
+			stats.tested_pairs += workers[worker].tested_pairs;
+			stats.filtered_pairs += workers[worker].filtered_pairs;
+		}
+
+		auto test = [&](cell_entry const& first, cell_entry const& second)
+		{
+			if (!can_collide(first.filter, second.filter))
+			{
+				++stats.filtered_pairs;
+				return;
+			}
+
+			++stats.tested_pairs;
+			if (math::intersect(first.bounds, second.bounds))
+			{
+				pairs.push_back(make_collision_pair(proxies[first.proxy].entity, proxies[second.proxy].entity));
+			}
+		};
+
+		for (uSize idx = 0; idx < oversized.size(); ++idx)
+		{
+			for (cell_entry const& entry : entries)
+			{
+				test(oversized[idx], entry);
+			}
+			for (uSize jdx = idx + 1; jdx < oversized.size(); ++jdx)
+			{
+				test(oversized[idx], oversized[jdx]);
+			}
+		}
+
+		stats.candidate_pairs = pairs.size();
+	}
+}
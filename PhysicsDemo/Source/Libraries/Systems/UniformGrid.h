@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Broadphase.h"
+#include "Workers.h"
+
+namespace jm
+{
+	//Uniform grid of cubic cells kept as a cell-sorted list. Every proxy is binned by the cell holding its centre, so a pair can
+	//only overlap if the two cells are neighbours. Proxies larger than a cell are tested against everything.
+	//Large scenes are split across threads by contiguous runs of cells, each writing its own pair list. The lists are joined
+	//in cell order, so the pairs come out in the same order whatever the thread count.
+	class uniform_grid_broadphase final : public broadphase
+	{
+	public:
+		//a thread count of zero uses every hardware thread, the threads come from pool which must outlive the grid
+		uniform_grid_broadphase(worker_pool& pool, f32 cell_size, u32 thread_count = 1);
+
+		void find_pairs(std::vector<collision_proxy> const& proxies, std::vector<collision_pair>& pairs) override;
+
+		void set_cell_size(f32 size);
+		f32 get_cell_size() const { return cell_size; }
+
+		void set_thread_count(u32 count);
+		u32 get_thread_count() const { return thread_count; }
+
+	private:
+		static constexpr uSize MinProxiesPerThread = 4096; //fewer are not worth handing to another thread
+
+		struct cell_entry
+		{
+			u64 key;
+			u32 proxy;
+			math::aabb3<f32> bounds; //copied so neighbouring cells are tested from contiguous memory
+			collision_filter filter;
+		};
+
+		struct worker_output
+		{
+			std::vector<cell_entry> entries;
+			std::vector<cell_entry> oversized;
+			std::vector<collision_pair> pairs;
+			uSize tested_pairs = 0;
+			uSize filtered_pairs = 0;
+		};
+
+		void build_cells(std::vector<collision_proxy> const& proxies, u32 worker_count);
+		void find_cell_pairs(std::vector<collision_proxy> const& proxies, u32 begin, u32 end, worker_output& output) const;
+
+		worker_pool* pool;
+		f32 cell_size;
+		u32 thread_count;
+		std::vector<cell_entry> entries; //sorted by cell key, z major
+		std::vector<cell_entry> oversized;
+		std::vector<worker_output> workers;
+	};
+}
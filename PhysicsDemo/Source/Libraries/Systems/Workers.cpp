@@ -0,0 +1,72 @@
+#include "Workers.h"
+
+namespace jm
+{
+	worker_pool::~worker_pool()
+	{
+		{
+			std::scoped_lock lock(mutex);
+			stopping = true;
+		}
+		job_ready.notify_all();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	void worker_pool::run_job(u32 worker_count, job_function job_fxn, void* job_context)
+	{
+		std::scoped_lock job_lock(job_mutex);
+		{
+			std::scoped_lock lock(mutex);
+			while (threads.size() + 1 < worker_count)
+			{
+				threads.emplace_back(&worker_pool::thread_main, this, static_cast<u32>(threads.size() + 1), job);
+			}
+
+			function = job_fxn;
+			context = job_context;
+			job_workers = worker_count;
+			pending_workers = worker_count - 1;
+			++job;
+		}
+		job_ready.notify_all();
+
+		job_fxn(job_context, 0u);
+
+		std::unique_lock lock(mutex);
+		job_done.wait(lock, [this]() { return pending_workers == 0; });
+	}
+
+	void worker_pool::thread_main(u32 worker, u64 seen_job)
+	{
+		std::unique_lock lock(mutex);
+		while (true)
+		{
+			job_ready.wait(lock, [this, seen_job]() { return stopping || job != seen_job; });
+			if (stopping)
+			{
+				return;
+			}
+
+			//a job only finishes once its workers have, so a thread never misses one it is a worker of
+			seen_job = job;
+			if (worker >= job_workers)
+			{
+				continue;
+			}
+
+			const job_function job_fxn = function;
+			void* const job_context = context;
+			lock.unlock();
+			job_fxn(job_context, worker);
+			lock.lock();
+
+			if (--pending_workers == 0)
+			{
+				job_done.notify_one();
+			}
+		}
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "MathTypes.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace jm
+{
+	//threads to split item_count items over, a thread count of zero means every hardware thread.
+	//Each thread gets at least min_items_per_worker items, so small jobs stay on the calling thread.
+	inline u32 get_worker_count(u32 thread_count, uSize item_count, uSize min_items_per_worker)
+	{
+		const u32 threads = thread_count == 0 ? std::max(1u, std::thread::hardware_concurrency()) : thread_count;
+		return static_cast<u32>(std::clamp<uSize>(item_count / min_items_per_worker, 1, threads));
+	}
+
+	//first item of chunk when count items are split into chunk_count even chunks
+	inline uSize chunk_begin(uSize count, u32 chunk, u32 chunk_count)
+	{
+		return count * chunk / chunk_count;
+	}
+
+	//Threads kept for the life of the pool, so a job costs a wake up rather than a thread per worker. Threads are started the
+	//first time a job needs them, each worker of a job has a thread of its own so workers may wait on each other. Jobs from
+	//several threads run one after another, a job must not start another on the same pool.
+	class worker_pool
+	{
+	public:
+		worker_pool() = default;
+		~worker_pool();
+
+		worker_pool(worker_pool const&) = delete;
+		worker_pool& operator=(worker_pool const&) = delete;
+
+		//runs work(worker) for every worker and waits for them all, the first on the calling thread
+		template <typename Fxn>
+		void run(u32 worker_count, Fxn&& work)
+		{
+			if (worker_count <= 1)
+			{
+				work(0u);
+				return;
+			}
+
+			using work_type = std::remove_reference_t<Fxn>;
+			run_job(worker_count, [](void* context, u32 worker) { (*static_cast<work_type*>(context))(worker); },
+				const_cast<void*>(static_cast<void const*>(std::addressof(work))));
+		}
+
+		u32 get_thread_count() const { return static_cast<u32>(threads.size()); } //started so far, the calling thread not included
+
+	private:
+		using job_function = void (*)(void* context, u32 worker);
+
+		void run_job(u32 worker_count, job_function function, void* context);
+		void thread_main(u32 worker, u64 seen_job);
+
+		std::vector<std::thread> threads; //thread i runs worker i + 1
+		std::mutex job_mutex; //held for a whole job
+		std::mutex mutex; //guards the job below
+		std::condition_variable job_ready;
+		std::condition_variable job_done;
+		job_function function = nullptr;
+		void* context = nullptr;
+		u32 job_workers = 0;
+		u32 pending_workers = 0;
+		u64 job = 0; //counts jobs, a thread runs each new one it is a worker of
+		bool stopping = false;
+	};
+}
@@ -0,0 +1,314 @@
+#include "XpbdSolver.h"
+#include "Shapes.h"
+#include "Simulation.h"
+#include "Math/Contact.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace jm
+{
+	u32 xpbd_solver::get_body(entity_registry& registry, entity_id entity)
+	{
+		const uSize entity_index = static_cast<uSize>(entt::to_entity(entity));
+		if (entity_index >= entity_bodies.size())
+		{
+			entity_bodies.resize(entity_index + 1, InvalidBody);
+		}
+
+		u32& mapped_body = entity_bodies[entity_index];
+		if (mapped_body == InvalidBody)
+		{
+			//only reached for statics and sleeping bodies, the awake ones are all added up front
+			const shape_component* shape = registry.try_get<shape_component>(entity);
+			spatial3_component const& spatial = registry.get<spatial3_component>(entity);
+			mapped_body = static_cast<u32>(bodies.size());
+			body_entities.push_back(entity);
+			bodies.push_back({ spatial, spatial.position, {}, {}, 0.0f, shape != nullptr ? *shape : shape_component::Sphere });
+		}
+		return mapped_body;
+	}
+
+	bool xpbd_solver::find_contact(body const& a, body const& b, math::vector3<f32>& normal, f32& depth) const
+	{
+		if (a.shape == shape_component::Sphere && b.shape == shape_component::Sphere)
+		{
+			const math::sphere3<f32> a_sphere = make_sphere(a.spatial);
+			const math::sphere3<f32> b_sphere = make_sphere(b.spatial);
+			const math::vector3<f32> offset = b_sphere.center - a_sphere.center;
+			const f32 radius = a_sphere.radius + b_sphere.radius;
+			const f32 distance_squared = glm::dot(offset, offset);
+			if (distance_squared >= radius * radius)
+			{
+				return false;
+			}
+
+			const f32 distance = std::sqrt(distance_squared);
+			normal = distance > math::epsilon<f32>() ? offset / distance : math::vector3<f32>{ 0.0f, 1.0f, 0.0f };
+			depth = radius - distance;
+			return true;
+		}
+
+		math::contact_manifold3<f32> manifold;
+		const bool touching = a.shape == shape_component::Sphere ? math::collide(make_sphere(a.spatial), make_box(b.spatial), manifold)
+			: b.shape == shape_component::Sphere ? math::collide(make_box(a.spatial), make_sphere(b.spatial), manifold)
+			: math::collide(make_box(a.spatial), make_box(b.spatial), manifold);
+		if (!touching || manifold.point_count == 0)
+		{
+			return false;
+		}
+
+		//without rotation every point of a manifold constrains the same translation, so only the deepest one matters
+		normal = manifold.normal;
+		depth = 0.0f;
+		for (u32 point = 0; point < manifold.point_count; ++point)
+		{
+			depth = std::max(depth, manifold.points[point].depth);
+		}
+		return depth > 0.0f;
+	}
+
+	void xpbd_solver::build_islands()
+	{
+		const u32 body_count = static_cast<u32>(dynamic_body_count);
+		body_sets.reset(body_count);
+		body_linked.assign(body_count, 0);
+
+		//statics, sleeping bodies and the world do not join islands, so a shared floor does not merge everything into one
+		const auto link = [this, body_count](u32 a, u32 b)
+			{
+				const bool a_dynamic = a < body_count;
+				const bool b_dynamic = b < body_count;
+				if (a_dynamic)
+				{
+					body_linked[a] = 1;
+				}
+				if (b_dynamic)
+				{
+					body_linked[b] = 1;
+				}
+				if (a_dynamic && b_dynamic)
+				{
+					body_sets.unite(a, b);
+				}
+			};
+		for (uSize idx = 0; idx < constraints.size(); ++idx)
+		{
+			if (constraint_touching[idx] != 0)
+			{
+				link(constraints[idx].a, constraints[idx].b);
+			}
+		}
+		for (joint_constraint const& joint : joints)
+		{
+			link(joint.a, joint.b);
+		}
+
+		//roots are the smallest body of their island, so numbering in body order labels every root before its members
+		body_islands.assign(body_count, InvalidBody);
+		island_body_offsets.assign(1, 0);
+		for (u32 body = 0; body < body_count; ++body)
+		{
+			if (body_linked[body] == 0)
+			{
+				continue;
+			}
+
+			const u32 root = body_sets.find(body);
+			if (root == body)
+			{
+				body_islands[body] = static_cast<u32>(island_body_offsets.size() - 1);
+				island_body_offsets.push_back(0);
+			}
+			else
+			{
+				body_islands[body] = body_islands[root];
+			}
+			++island_body_offsets[body_islands[body] + 1];
+		}
+		for (uSize island = 1; island < island_body_offsets.size(); ++island)
+		{
+			island_body_offsets[island] += island_body_offsets[island - 1];
+		}
+
+		island_entities.resize(island_body_offsets.back());
+		island_velocities.resize(island_body_offsets.back());
+		std::vector<u32> cursors(island_body_offsets.begin(), island_body_offsets.end() - 1);
+		for (u32 body = 0; body < body_count; ++body)
+		{
+			if (body_islands[body] != InvalidBody)
+			{
+				const u32 slot = cursors[body_islands[body]]++;
+				island_entities[slot] = body_entities[body];
+				island_velocities[slot] = bodies[body].velocity * Damping;
+			}
+		}
+	}
+
+	void xpbd_solver::step(entity_registry& registry, std::vector<collision_pair> const& candidates, xpbd_settings const& settings, f32 delta_time,
+		std::vector<collision_pair>& touching)
+	{
+		body_entities.clear();
+		bodies.clear();
+		for (auto&& [entity, linear, spatial] : get_awake_bodies(registry).each())
+		{
+			//a body without a shape never meets a contact, only joints
+			const shape_component* shape = registry.try_get<shape_component>(entity);
+			const uSize entity_index = static_cast<uSize>(entt::to_entity(entity));
+			if (entity_index >= entity_bodies.size())
+			{
+				entity_bodies.resize(entity_index + 1, InvalidBody);
+			}
+			entity_bodies[entity_index] = static_cast<u32>(bodies.size());
+			body_entities.push_back(entity);
+			bodies.push_back({ spatial, spatial.position, linear.velocity, Gravity + linear.applied_force * linear.inverse_mass, linear.inverse_mass,
+				shape != nullptr ? *shape : shape_component::Sphere });
+		}
+		dynamic_body_count = bodies.size();
+
+		constraints.clear();
+		for (collision_pair const& pair : candidates)
+		{
+			const u32 a = get_body(registry, pair.a);
+			const u32 b = get_body(registry, pair.b);
+			const bool both_dynamic = a < dynamic_body_count && b < dynamic_body_count;
+			constraints.push_back({ a, b, both_dynamic ? settings.compliance.contact : settings.compliance.static_contact });
+		}
+		constraint_touching.assign(constraints.size(), 0);
+
+		joints.clear();
+		for (auto&& [entity, joint] : registry.view<const joint_component>().each())
+		{
+			if (!registry.valid(joint.a) || (joint.b != null_entity_id && !registry.valid(joint.b)))
+			{
+				continue;
+			}
+
+			spatial3_component const& spatial_a = registry.get<spatial3_component>(joint.a);
+			joint_constraint constraint{ get_body(registry, joint.a), InvalidBody, spatial_a.orientation * joint.local_anchor_a, joint.local_anchor_b,
+				joint.type == joint_type::Distance ? joint.length : -1.0f };
+			if (joint.b != null_entity_id)
+			{
+				constraint.b = get_body(registry, joint.b);
+				constraint.anchor_b = registry.get<spatial3_component>(joint.b).orientation * joint.local_anchor_b;
+			}
+			joints.push_back(constraint);
+		}
+
+		first_touching.clear();
+		const u32 substeps = std::max(settings.substeps, 1u);
+		const f32 substep_time = delta_time / static_cast<f32>(substeps);
+		const f32 compliance_scale = 1.0f / (substep_time * substep_time);
+		for (u32 substep = 0; substep < substeps; ++substep)
+		{
+			for (uSize idx = 0; idx < dynamic_body_count; ++idx)
+			{
+				body& dynamic = bodies[idx];
+				dynamic.previous_position = dynamic.spatial.position;
+				dynamic.velocity += dynamic.acceleration * substep_time;
+				dynamic.spatial.position += dynamic.velocity * substep_time;
+			}
+
+			//one projection per contact, its multiplier starts from zero every substep so there is nothing to carry over
+			for (uSize idx = 0; idx < constraints.size(); ++idx)
+			{
+				contact_constraint const& constraint = constraints[idx];
+				body& a = bodies[constraint.a];
+				body& b = bodies[constraint.b];
+				const f32 inverse_mass = a.inverse_mass + b.inverse_mass;
+
+				math::vector3<f32> normal;
+				f32 depth;
+				constraint_touching[idx] = find_contact(a, b, normal, depth) ? 1 : 0;
+				if (constraint_touching[idx] == 0 || inverse_mass <= 0.0f)
+				{
+					continue;
+				}
+
+				const f32 multiplier = depth / (inverse_mass + constraint.compliance * compliance_scale);
+				a.spatial.position -= normal * (multiplier * a.inverse_mass);
+				b.spatial.position += normal * (multiplier * b.inverse_mass);
+
+				//friction takes back the sliding over the substep, up to the coefficient times how far the contact pushed
+				const math::vector3<f32> slip = (b.spatial.position - b.previous_position) - (a.spatial.position - a.previous_position);
+				const math::vector3<f32> tangent_slip = slip - dot(slip, normal) * normal;
+				const f32 slip_length = glm::length(tangent_slip);
+				if (slip_length > math::epsilon<f32>())
+				{
+					const math::vector3<f32> correction = tangent_slip * (std::min(slip_length, settings.friction * multiplier * inverse_mass) / (slip_length * inverse_mass));
+					a.spatial.position += correction * a.inverse_mass;
+					b.spatial.position -= correction * b.inverse_mass;
+				}
+			}
+
+			//the error is the anchors' offset, or how far it is off the length along the line between them
+			const f32 joint_compliance = settings.compliance.joint * compliance_scale;
+			for (joint_constraint const& joint : joints)
+			{
+				body& a = bodies[joint.a];
+				const bool on_world = joint.b == InvalidBody;
+				const f32 inverse_mass = a.inverse_mass + (on_world ? 0.0f : bodies[joint.b].inverse_mass);
+				if (inverse_mass <= 0.0f)
+				{
+					continue;
+				}
+
+				const math::vector3<f32> anchor_b = on_world ? joint.anchor_b : bodies[joint.b].spatial.position + joint.anchor_b;
+				math::vector3<f32> error = anchor_b - (a.spatial.position + joint.anchor_a);
+				if (joint.length >= 0.0f)
+				{
+					const f32 distance = glm::length(error);
+					if (distance <= math::epsilon<f32>())
+					{
+						continue;
+					}
+					error *= (distance - joint.length) / distance;
+				}
+
+				const math::vector3<f32> correction = error / (inverse_mass + joint_compliance);
+				a.spatial.position += correction * a.inverse_mass;
+				if (!on_world)
+				{
+					bodies[joint.b].spatial.position -= correction * bodies[joint.b].inverse_mass;
+				}
+			}
+
+			for (uSize idx = 0; idx < dynamic_body_count; ++idx)
+			{
+				body& dynamic = bodies[idx];
+				dynamic.velocity = (dynamic.spatial.position - dynamic.previous_position) / substep_time;
+			}
+
+			if (substep == 0)
+			{
+				for (uSize idx = 0; idx < candidates.size(); ++idx)
+				{
+					if (constraint_touching[idx] != 0)
+					{
+						first_touching.push_back(candidates[idx]);
+					}
+				}
+			}
+		}
+		build_islands();
+
+		for (uSize idx = 0; idx < dynamic_body_count; ++idx)
+		{
+			registry.get<spatial3_component>(body_entities[idx]).position = bodies[idx].spatial.position;
+			registry.get<linear_body3_component>(body_entities[idx]).velocity = bodies[idx].velocity * Damping;
+		}
+		for (entity_id entity : body_entities)
+		{
+			entity_bodies[static_cast<uSize>(entt::to_entity(entity))] = InvalidBody;
+		}
+
+		touching.clear();
+		for (uSize idx = 0; idx < candidates.size(); ++idx)
+		{
+			if (constraint_touching[idx] != 0)
+			{
+				touching.push_back(candidates[idx]);
+			}
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Entity.h"
+#include "Broadphase.h"
+#include "Components.h"
+#include "Math/DisjointSet.h"
+
+#include <span>
+
+namespace jm
+{
+	//compliance is the inverse of stiffness in metres per newton, zero is rigid
+	struct xpbd_compliance
+	{
+		f32 contact = 0.0f; //between two bodies
+		f32 static_contact = 0.0f; //against statics and sleeping bodies
+		f32 joint = 0.0f;
+	};
+
+	struct xpbd_settings
+	{
+		u32 substeps = 8;
+		f32 pair_margin = 0.1f; //candidate bounds grow by this beyond the step's motion, covers the velocity gained during the step
+		f32 friction = 0.5f; //Coulomb coefficient, a contact takes back sliding of at most this times how far it pushed
+		xpbd_compliance compliance;
+	};
+
+	//Extended position based dynamics with small steps. Every substep predicts positions from velocities, projects each
+	//contact once along its normal and then against its sliding, and derives velocities from how far the bodies moved.
+	//Candidate pairs are found once per step and tested again at every substep, so bodies can come into contact part way
+	//through a step. Joints are projected after the contacts.
+	//Integrates the awake bodies itself, statics and sleeping bodies take part in contacts and joints but never move.
+	//Bodies joined through contacts still touching at the end of the step or through joints are grouped into islands the way
+	//the impulse solver groups them, for sleeping to work on.
+	class xpbd_solver
+	{
+	public:
+		//touching receives the candidates still touching at the last substep
+		void step(entity_registry& registry, std::vector<collision_pair> const& candidates, xpbd_settings const& settings, f32 delta_time,
+			std::vector<collision_pair>& touching);
+
+		uSize get_body_count() const { return dynamic_body_count; }
+		uSize get_constraint_count() const { return constraints.size(); }
+		uSize get_joint_count() const { return joints.size(); }
+
+		//candidates that touched at the first substep of the last step, the ones that should wake a sleeping body
+		std::vector<collision_pair> const& get_first_touching() const { return first_touching; }
+
+		u32 get_island_count() const { return static_cast<u32>(island_body_offsets.size() - 1); }
+
+		//bodies of an island from the last step, valid until the next one
+		std::span<entity_id const> get_island_entities(u32 island) const
+		{
+			return { island_entities.data() + island_body_offsets[island], island_entities.data() + island_body_offsets[island + 1] };
+		}
+
+		//velocities the last step left those bodies with, in the same order
+		std::span<math::vector3<f32> const> get_island_velocities(u32 island) const
+		{
+			return { island_velocities.data() + island_body_offsets[island], island_velocities.data() + island_body_offsets[island + 1] };
+		}
+
+	private:
+		static constexpr u32 InvalidBody = ~u32(0);
+
+		struct body
+		{
+			spatial3_component spatial;
+			math::vector3<f32> previous_position;
+			math::vector3<f32> velocity;
+			math::vector3<f32> acceleration;
+			f32 inverse_mass;
+			shape_component shape;
+		};
+
+		struct contact_constraint
+		{
+			u32 a, b;
+			f32 compliance;
+		};
+
+		struct joint_constraint
+		{
+			u32 a, b; //b is InvalidBody on the world
+			math::vector3<f32> anchor_a, anchor_b; //offsets in world axes, bodies do not turn, or the world point
+			f32 length; //negative holds the anchors together
+		};
+
+		u32 get_body(entity_registry& registry, entity_id entity);
+		//normal points from a to b, returns false when they do not touch
+		bool find_contact(body const& a, body const& b, math::vector3<f32>& normal, f32& depth) const;
+		void build_islands();
+
+		std::vector<entity_id> body_entities;
+		std::vector<u32> entity_bodies; //entity index to solver body
+		std::vector<body> bodies; //the dynamic bodies first, then every static or sleeping body a candidate touches
+		uSize dynamic_body_count = 0;
+		std::vector<contact_constraint> constraints;
+		std::vector<u8> constraint_touching;
+		std::vector<joint_constraint> joints;
+		std::vector<collision_pair> first_touching;
+
+		math::disjoint_set body_sets;
+		std::vector<u8> body_linked; //dynamic bodies with a contact or joint, the rest are in no island
+		std::vector<u32> body_islands;
+		std::vector<u32> island_body_offsets = { 0 };
+		std::vector<entity_id> island_entities;
+		std::vector<math::vector3<f32>> island_velocities;
+	};
+}